@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       BmpCarrier.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: memory-mapped BMP carriers.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "BmpCarrier.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define STEGO_MMAP 1
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace f2i_stego_tools {
+
+    //
+    // helpers
+    //
+
+    // little-endian fields of the BMP file and info headers
+    inline unsigned long rd32(const unsigned char* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long)p[3] << 24);
+    }
+
+    inline unsigned int rd16(const unsigned char* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+#ifdef STEGO_MMAP
+
+    // mode std::ofstream would create a file with (0666 less the umask);
+    // umask() can only be read by setting it, so it is read once, before
+    // main() while there is a single thread
+    mode_t new_file_mode() {
+        mode_t mask = umask(0);
+        umask(mask);
+        return 0666 & ~mask;
+    }
+
+    const mode_t NEW_FILE_MODE = new_file_mode();
+
+    // copies the whole of in to out, letting the kernel move the bytes when it can
+    bool copy_fd(int in, int out, std::size_t length) {
+        std::size_t done = 0;
+#ifdef __linux__
+        while (done < length) {
+            ssize_t r = copy_file_range(in, NULL, out, NULL, length - done, 0);
+            if (r <= 0) break;
+            done += r;
+        }
+        if (done == length) return true;
+        if (lseek(in, done, SEEK_SET) < 0 || lseek(out, done, SEEK_SET) < 0) return false;
+#endif
+        std::vector<char> buf(1 << 20);
+        while (done < length) {
+            ssize_t r = read(in, &buf[0], buf.size());
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            for (ssize_t w = 0; w < r; ) {
+                ssize_t k = write(out, &buf[w], r - w);
+                if (k < 0 && errno == EINTR) continue;
+                if (k <= 0) return false;
+                w += k;
+            }
+            done += r;
+        }
+        return true;
+    }
+
+#endif
+
+    //
+    // MappedBmp
+    //
+
+    MappedBmp::MappedBmp()
+        : data(NULL), length(0), offset(0), stride(0), w(0), h(0), top_down(false) {}
+
+    MappedBmp::~MappedBmp() {
+        close();
+        if (!tmp_path.empty()) std::remove(tmp_path.c_str());
+    }
+
+    void MappedBmp::close() {
+#ifdef STEGO_MMAP
+        if (data) munmap(data, length);
+#endif
+        data = NULL;
+        length = 0;
+    }
+
+    bool MappedBmp::map(int fd, bool writable) {
+#ifdef STEGO_MMAP
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < 54) return false;
+        length = (std::size_t)st.st_size;
+        void* p = mmap(NULL, length, writable ? PROT_READ|PROT_WRITE : PROT_READ,
+                       writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            length = 0;
+            return false;
+        }
+        data = (unsigned char*)p;
+
+        // only the plain 24-bit BI_RGB layout is handled here
+        long height;
+        if (data[0] != 'B' || data[1] != 'M' || rd32(data+14) < 40 ||
+            rd16(data+26) != 1 || rd16(data+28) != 24 || rd32(data+30) != 0) {
+            close();
+            return false;
+        }
+        offset = rd32(data+10);
+        w = (int)rd32(data+18);
+        height = (long)(int)rd32(data+22);
+        top_down = height < 0;
+        h = (int)(top_down ? -height : height);
+        stride = ((long)w*3 + 3) & ~3L;
+        if (w <= 0 || h <= 0 || offset > length ||
+            (unsigned long long)stride*h > length - offset) {
+            close();
+            return false;
+        }
+        return true;
+#else
+        (void)fd;
+        (void)writable;
+        return false;
+#endif
+    }
+
+    bool MappedBmp::open(std::string path) {
+#ifdef STEGO_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool ok = map(fd, false);
+        ::close(fd);
+        return ok;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    bool MappedBmp::open_copy(std::string src, std::string dst) {
+#ifdef STEGO_MMAP
+        int in = ::open(src.c_str(), O_RDONLY);
+        if (in < 0) return false;
+
+        // check the source before copying anything
+        if (!map(in, false)) {
+            ::close(in);
+            return false;
+        }
+        std::size_t size = length;
+        close();
+
+        // copy next to the destination so commit() is a rename; the name is
+        // unique, so jobs writing the same destination (or a leftover copy)
+        // never share a file
+        std::vector<char> tmp(dst.begin(), dst.end());
+        const char suffix[] = ".XXXXXX";
+        tmp.insert(tmp.end(), suffix, suffix + sizeof(suffix));
+        int out = mkstemp(&tmp[0]);
+        if (out < 0) {
+            ::close(in);
+            return false;
+        }
+        tmp_path = &tmp[0];
+
+        // mkstemp() creates the copy as 0600; give it the mode a new file gets
+        bool ok = fchmod(out, NEW_FILE_MODE) == 0 && copy_fd(in, out, size) && map(out, true);
+        ::close(in);
+        ::close(out);
+        if (!ok) {
+            std::remove(tmp_path.c_str());
+            tmp_path.clear();
+            return false;
+        }
+        dst_path = dst;
+        return true;
+#else
+        (void)src;
+        (void)dst;
+        return false;
+#endif
+    }
+
+    bool MappedBmp::commit() {
+#ifdef STEGO_MMAP
+        if (!data || tmp_path.empty()) return false;
+
+        // the pages written are already in the file (a shared mapping), so
+        // only those reach the disk, whenever the kernel writes them back
+        close();
+        if (std::rename(tmp_path.c_str(), dst_path.c_str()) != 0) return false;
+        tmp_path.clear();
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool read_bmp_rows(std::string path, unsigned long long bytes, std::vector<unsigned char>& rgb,
+                       int& width, int& height, int& rows) {
+        std::ifstream ifs(path.c_str(), std::ios::binary|std::ios::in);
+        unsigned char hdr[54];
+        if (!ifs.read((char*)hdr, sizeof(hdr))) return false;
+
+        // the same layout checks as MappedBmp::map
+        if (hdr[0] != 'B' || hdr[1] != 'M' || rd32(hdr+14) < 40 ||
+            rd16(hdr+26) != 1 || rd16(hdr+28) != 24 || rd32(hdr+30) != 0)
+            return false;
+        unsigned long long offset = rd32(hdr+10);
+        width = (int)rd32(hdr+18);
+        long h = (long)(int)rd32(hdr+22);
+        bool top_down = h < 0;
+        height = (int)(top_down ? -h : h);
+        long stride = ((long)width*3 + 3) & ~3L;
+        if (width <= 0 || height <= 0 || !ifs.seekg(0, std::ios::end)) return false;
+        unsigned long long length = (unsigned long long)ifs.tellg();
+        if (offset > length || (unsigned long long)stride*height > length - offset) return false;
+
+        // rows holding the first bytes, one read each
+        unsigned long long row_bytes = (unsigned long long)width*3;
+        rows = (int)std::min<unsigned long long>(bytes / row_bytes + (bytes % row_bytes != 0), height);
+        rgb.resize((size_t)(row_bytes * rows));
+        std::vector<unsigned char> row((size_t)row_bytes);
+        for (int y=0; y<rows; y++) {
+            unsigned long long at = offset + (unsigned long long)stride * (top_down ? y : height-1-y);
+            if (!ifs.seekg((std::streamoff)at) || !ifs.read((char*)&row[0], (std::streamsize)row_bytes))
+                return false;
+            // B,G,R to R,G,B
+            unsigned char* out = &rgb[(size_t)(row_bytes * y)];
+            for (unsigned long long x=0; x<row_bytes; x+=3) {
+                out[x] = row[x+2];
+                out[x+1] = row[x+1];
+                out[x+2] = row[x];
+            }
+        }
+        return true;
+    }
+
+    RGBView MappedBmp::view() {
+
+        // rows hold B,G,R triples bottom row first unless the height was
+        // negative; start at the red byte of the top-left pixel and walk
+        // channels backwards
+        unsigned char* top = data + offset + (top_down ? 0 : (h-1)*stride);
+        return RGBView(top + 2, w, h, -1, 3, top_down ? stride : -stride);
+    }
+}
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       BmpCarrier.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: memory-mapped BMP carriers.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _BMPCARRIER_H_
+#define _BMPCARRIER_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "File2ImageStegoTools.h"
+
+namespace f2i_stego_tools {
+
+    // a 24-bit uncompressed BMP file mapped into memory, so its pixel rows are
+    // read and written in place instead of being decoded into a CImg and
+    // encoded again (only available where mmap is)
+    class MappedBmp {
+    public:
+        MappedBmp();
+
+        // unmaps the file; a copy that was never committed is removed
+        ~MappedBmp();
+
+        // maps a BMP read-only; false if it is not a BMP this class handles
+        bool open(std::string path);
+
+        // copies src to a uniquely named temporary file next to dst (inside
+        // the kernel where possible) and maps the copy for writing
+        bool open_copy(std::string src, std::string dst);
+
+        // unmaps the copy and moves it over dst
+        bool commit();
+
+        int width() const { return w; }
+        int height() const { return h; }
+
+        // R,G,B view over the mapped pixel rows
+        RGBView view();
+
+    private:
+        // not copyable
+        MappedBmp(const MappedBmp&);
+        MappedBmp& operator=(const MappedBmp&);
+
+        bool map(int fd, bool writable);
+        void close();
+
+        unsigned char* data;    // whole file
+        std::size_t length;     // bytes in the file
+        std::size_t offset;     // start of the pixel array
+        long stride;            // bytes per row, including padding
+        int w, h;
+        bool top_down;          // rows stored top row first (negative height)
+        std::string tmp_path;   // uncommitted copy
+        std::string dst_path;   // where the copy goes on commit
+    };
+
+    // reads the start of a 24-bit uncompressed BMP's R,G,B stream, i.e. the
+    // whole rows (top row first) holding its first bytes, into rgb as
+    // interleaved R,G,B; only the file header and those rows are read, not
+    // the rest of the pixel array (all of it for bytes = ~0ULL). False if it
+    // is not a BMP MappedBmp handles
+    bool read_bmp_rows(std::string path, unsigned long long bytes, std::vector<unsigned char>& rgb,
+                       int& width, int& height, int& rows);
+}
+
+#endif   // !defined _BMPCARRIER_H_
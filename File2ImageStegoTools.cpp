@@ -1,494 +1,2189 @@
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Author:         Ibrahim Sardar
-//  Class:          CSCI 557
-//  Filename:       File2ImageStegoTools.cpp
-//  Date:           04/20/2018
-//  Description:    Main implementation for Stenography: File-to-Image Tools namespace.
-//
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Honor Pledge:
-//
-//  I pledge that I have neither given nor received any help on this project.
-//
-//  ibsardar
-//
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
-//
-////////////////////////////////////////////////////////////////////////////////
-
-#include "File2ImageStegoTools.h"
-
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <bitset>
-#include <sstream>
-#include "math.h"
-#include "CImg.h"
-
-namespace f2i_stego_tools {
-
-    //
-    // structures
-    //
-
-    struct Header {
-        std::bitset<32> f_size;                 // number bits file data is taking up
-        std::bitset<11> h_size;                 // number bits header is taking up
-        std::bitset<3> lsbs;                    // least significant bits
-        std::bitset<2> code;                    // "11" = file to image encryption
-        std::bitset<8> separator;               // separates header expressions
-        std::bitset<8> separator2;              // separates header expressions (backup just in case)
-        std::bitset<11> width;                  // width of image
-        std::bitset<11> height;                 // height of image
-        std::vector<std::bitset<8> > extension; // extension of data file
-    };
-
-    //
-    // functions
-    //
-
-    int s2i(std::string str) {
-        // converts string to int
-        std::stringstream ss(str);
-        int i;
-        ss >> i;
-        return i;
-    }
-
-    std::string i2s (int i) {
-        // converts int to string
-        std::stringstream ss;
-        std::string str;
-        ss << i;
-        ss >> str;
-        return str;
-    }
-
-    unsigned int b2ui(unsigned char c) {
-
-        // convert character byte into binary int
-        std::bitset<8> binary(c);
-        return (unsigned int)(binary.to_ulong());
-    }
-
-    unsigned char ui2b(unsigned int i) {
-
-        // convert binary int into character byte
-        std::bitset<8> binary(i);
-        return (unsigned char)(binary.to_ulong());
-    }
-
-    unsigned int bs2ui(std::bitset<8>& byte) {
-
-        // convert byte into int value
-        return (unsigned int)(byte.to_ulong());
-    }
-
-    unsigned char bs2b(std::bitset<8> binary) {
-
-        // static cast bitset to u-char
-        return static_cast<unsigned char>(binary.to_ulong());
-    }
-
-    std::bitset<8> s2bs(std::string s) {
-
-        // place binary string into a bitset
-        return std::bitset<8>(s);
-    }
-
-    std::bitset<8> ui2bs(unsigned int i) {
-
-        // place binary int into a bitset
-        return std::bitset<8> (i);
-    }
-
-    std::bitset<8> b2bs(unsigned char c) {
-
-        // place binary character into a bitset
-        return std::bitset<8> (c);
-    }
-
-    std::vector<std::bitset<8> > get_data_from_img(cimg_library::CImg<unsigned char>& img) {
-        std::vector<std::bitset<8> > bytes;
-        for (int y=0; y<img.height(); y++) {
-            for (int x=0; x<img.width(); x++) {
-                bytes.push_back(b2bs(img(x,y,0))); //R
-                bytes.push_back(b2bs(img(x,y,1))); //G
-                bytes.push_back(b2bs(img(x,y,2))); //B
-            }
-        }
-
-        return bytes;
-    }
-
-    std::vector<std::bitset<8> > get_extension_data(std::string f) {
-        std::vector<std::bitset<8> > bytes;
-        int index = (int) f.find_last_of(".");
-        std::string ext = f.substr(index);
-        for (int i=1; i<ext.size(); i++) {  // skip the "." character
-            bytes.push_back(b2bs(ext[i]));
-        }
-        return bytes;
-    }
-
-    Header create_header_data(cimg_library::CImg<unsigned char>& img,
-                              std::vector<std::bitset<8> >& e, int code,
-                              int bits, std::vector<std::bitset<8> >& fdata){
-        Header h;
-        h.width = std::bitset<11> (img.width());
-        h.height = std::bitset<11> (img.height());
-        h.code = std::bitset<2> (i2s(code));
-        h.lsbs = std::bitset<3> (bits);
-        h.separator = std::bitset<8>('x');
-        h.separator2 = std::bitset<8>('\n');
-        h.extension = e;
-        // code,least significant bits,x,width,x,height,x,f_size,x,extension,x,
-        h.h_size = std::bitset<11>(2+3+8+11+8+11+8+32+8+(e.size()*8)+8);
-        // number of bits making up the data file to encrypt
-        h.f_size = std::bitset<32>(fdata.size()*8);
-        return h;
-    }
-
-    void encrypt(std::string img_filename, std::string file_filename,
-                 int least_significant_bits) {
-
-        //
-        //  Preparation
-        //
-
-        // read binary
-        std::ifstream ifs(file_filename.c_str(), std::ios::binary|std::ios::in);
-
-        // couldn't read :(
-        if (!ifs) {
-            std::cout << "ERROR: Data file could not be opened." << std::endl;
-            return;
-        }
-
-        // get binary bitsets from data file to encrypt
-        std::vector<std::bitset<8> > fdata;
-        while (ifs.peek() != -1) {
-            fdata.push_back(b2bs(ifs.get()));
-        }
-
-        // close the filestream
-        ifs.close();
-
-        // exception if something went wrong
-        if (ifs.bad()) {
-            std::cout << "ERROR: Data file could not be opened properly." << std::endl;
-            return;
-        }
-
-        // get CImg representation
-        cimg_library::CImg<unsigned char> img(img_filename.c_str());
-
-        // get binary bitsets from image to encrypt
-        std::vector<std::bitset<8> > idata = get_data_from_img(img);
-
-        // get extension of file into bitset vector
-        std::vector<std::bitset<8> > extension = get_extension_data(file_filename);
-        int ext_size = 8 * extension.size();
-
-        // construct header data
-        Header hdata = create_header_data(img, extension, 11, least_significant_bits, fdata);
-
-        //
-        //  Validate input size
-        //
-
-        // disallow encryption if file cannot fit into image
-        int total_bits = hdata.h_size.to_ulong() + hdata.f_size.to_ulong();
-        int bytes_available = idata.size();
-        int bytes_needed = (int)ceil((double)total_bits/least_significant_bits);
-        int result = bytes_available - bytes_needed;
-        int result_bits = bytes_available*least_significant_bits - total_bits;
-        std::cout<<"("<<total_bits<<" encryption bits/"<<bytes_available*8<<" image bits/"<<least_significant_bits<<" least significant bits)"<<std::endl;
-        if (result < 0) {
-            std::cout<<"ERROR: Data file is too large/image file is too small."<<std::endl;
-            std::cout<<-1*result<<" bytes ("<<-1*result_bits<<" bits or "<<-1*result/3<<" pixels) are needed to encrypt the given image."<<std::endl;
-            return;
-        } else {
-            std::cout<<"There is a surplus of "<<result<<" bytes ("<<result_bits<<" bits or "<<result/3<<" pixels) in the image."<<std::endl;
-        }
-
-        //
-        //  Gather bits to encrypt
-        //
-
-        // add header data to list of booleans
-        std::vector<bool> bools;
-        //code
-        bools.push_back(hdata.code[0]); bools.push_back(hdata.code[1]);
-        //lsbs
-        bools.push_back(hdata.lsbs[0]); bools.push_back(hdata.lsbs[1]);
-        bools.push_back(hdata.lsbs[2]);
-        //separator
-        for (int i=0;i<8;i++) bools.push_back(hdata.separator[i]);
-        //width
-        for (int i=0;i<11;i++) bools.push_back(hdata.width[i]);
-        //separator
-        for (int i=0;i<8;i++) bools.push_back(hdata.separator[i]);
-        //height
-        for (int i=0;i<11;i++) bools.push_back(hdata.height[i]);
-        //separator
-        for (int i=0;i<8;i++) bools.push_back(hdata.separator[i]);
-        //extension
-        for (int i=0;i<hdata.extension.size();i++)
-            for (int j=0;j<8;j++)
-                bools.push_back(hdata.extension[i][j]);
-        //separator (backup)
-        for (int i=0;i<8;i++) bools.push_back(hdata.separator2[i]);
-        //data file size (in bits)
-        for (int i=0;i<32;i++) bools.push_back(hdata.f_size[i]);
-        //separator
-        for (int i=0;i<8;i++) bools.push_back(hdata.separator[i]);
-
-        // add file data to boolean list
-        for(int i=0; i<fdata.size(); i++) {
-            for (int j=0; j<8; j++) {
-                bools.push_back(fdata[i][j]);
-            }
-        }
-
-        //
-        // encrypt
-        //
-
-        // helper vars
-        int changed = 0;
-        unsigned char rgb_tmp[3];
-        std::bitset<8> pixdata[3] = {std::bitset<8>(0), std::bitset<8>(0), std::bitset<8>(0)};
-
-        // First encrypt the first 5 bits of bools into the first 4 bytes (lsbs=2 for first 2 bits, =1 for next 3 bits)
-        pixdata[0] = idata[0]; pixdata[1] = idata[1]; pixdata[2] = idata[2];
-        pixdata[0][0] = bools[0]; pixdata[0][1] = bools[1]; pixdata[1][0] = bools[2]; pixdata[2][0] = bools[3];
-        rgb_tmp[0] = bs2b(pixdata[0]); rgb_tmp[1] = bs2b(pixdata[1]); rgb_tmp[2] = bs2b(pixdata[2]);
-        img.draw_point(0,0,rgb_tmp);
-        changed++;
-        pixdata[0] = idata[3];
-        pixdata[0][0] = bools[4];
-
-        // encrypt the rest
-        for (int i=32,j=5;j<bools.size();i++) { // i=image index, j=data index (bools)
-            int bit = i % 8;
-            int byte = i / 8;
-            int color = byte % 3; //R=0, G=1, B=2
-            int pixel = byte / 3;
-            int x = pixel % img.width();
-            int y = pixel / img.width();
-            bool zone = (bit >= hdata.lsbs.to_ulong() ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            // if zone is 0, fill an idata bit, if zone is 1, fill a bools bit
-            if (zone == 0) {
-                pixdata[color][bit] = idata[byte][bit];
-            } else if (zone == 1) {
-                pixdata[color][bit] = bools[j];
-                j++;
-            }
-            // draw a pixel if the index is at the end of a set of 3 bytes OR
-            //              if end of encryption data reached
-            if ((color == 2 && bit == 7) || j==bools.size()-1) {
-                unsigned char rgb[3] = {bs2b(pixdata[0]), bs2b(pixdata[1]), bs2b(pixdata[2])};
-                img.draw_point(x,y,rgb);
-                changed++;
-            }
-        }
-        std::string new_img_filename = "encrypted.bmp";
-        img.save(new_img_filename.c_str());
-        std::cout<<changed<<"/"<<img.width()*img.height()<<" pixels were encrypted."<<std::endl;
-        std::cout << "Encryption successful; saved as \"encrypted.bmp\"." << std::endl;
-    }
-
-    void decrypt(std::string fp) {
-
-        //
-        //  Read image file via CImg
-        //
-
-        // get CImg representation
-        cimg_library::CImg<unsigned char> img(fp.c_str());
-
-        // get image data
-        std::vector<std::bitset<8> > img_data = get_data_from_img(img);
-
-        //
-        //  Gather header info
-        //
-
-        // this will store gathered header info
-        Header h;
-
-        // bits >> code, lsbs
-        // first 4 bytes contain the code and least significant bit amount
-        h.code[0] = img_data[0][0];
-        h.code[1] = img_data[0][1];
-        h.lsbs[0] = img_data[1][0];
-        h.lsbs[1] = img_data[2][0];
-        h.lsbs[2] = img_data[3][0];
-        int code = h.code.to_ulong();
-        int lsbs = h.lsbs.to_ulong();
-        // validate
-        if (code != 3 || (lsbs < 1 || lsbs > 7)) {
-            std::cout << "ERROR: Encryption corrupted." << std::endl;
-            return;
-        }
-
-        // bits >> separator #1
-        int curr_img_bit = 32, curr_encoded_bit = 5, bit_cnt = 0;
-        for (int i=curr_img_bit, j=curr_encoded_bit;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.separator[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+8) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        // validate
-        if (bs2b(h.separator) != 'x') {
-            std::cout << "ERROR: Encryption corrupted." << std::endl;
-            return;
-        }
-
-        // bits >> width, separator #2, height
-        for (int i=curr_img_bit, j=curr_encoded_bit, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.width[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+11) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        for (int i=curr_img_bit, j=curr_encoded_bit, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.separator[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+8) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        for (int i=curr_img_bit, j=curr_encoded_bit, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.height[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+11) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        // validate
-        if (h.width.to_ulong() != img.width() ||
-            bs2b(h.separator) != 'x' ||
-            h.height.to_ulong() != img.height()) {
-            std::cout << "ERROR: Encryption corrupted." << std::endl;
-            return;
-        }
-
-        // bits >> separator #3, extension, separator #4
-        for (int i=curr_img_bit, j=curr_encoded_bit, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.separator[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+8) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        h.extension.push_back(std::bitset<8>());
-        for (int i=curr_img_bit, j=curr_encoded_bit, index=0, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.extension[index][bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+8) { // if 1 byte completed
-                curr_img_bit = 1+i; curr_encoded_bit = j; index++; bit_cnt=0;
-                if (bs2b(h.extension[index-1]) == '\n') { h.extension.pop_back(); break; }
-                h.extension.push_back(std::bitset<8>());
-            }
-        }
-        // validate
-        if (bs2b(h.separator) != 'x') {
-            std::cout << "ERROR: Encryption corrupted." << std::endl;
-            return;
-        }
-
-        // bits >> f_size, separator #5
-        for (int i=curr_img_bit, j=curr_encoded_bit, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.f_size[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+32) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        for (int i=curr_img_bit, j=curr_encoded_bit, bit_cnt=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { h.separator[bit_cnt] = img_data[byte][bit]; j++; bit_cnt++; }
-            if (j >= curr_encoded_bit+8) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-        // validate
-        if (bs2b(h.separator) != 'x') {
-            std::cout << "ERROR: Encryption corrupted." << std::endl;
-            return;
-        }
-
-        // this will store the encrypted file's data, bit by bit
-        std::vector<bool> f_data;
-
-        // size of encrypted data in bits
-        long f_size = h.f_size.to_ulong();
-
-        // loop through each bit until we reach the limit (f_size)
-        for (int i=curr_img_bit, j=0;; i++) { // j = encoded bit, i = image bit
-            int bit = i % 8, byte = i / 8;
-            bool zone = (bit >= lsbs ? 0 : 1); // zone indicates whether current bit is in lsbs area
-            if (zone) { f_data.push_back(img_data[byte][bit]); j++; }
-            if (j >= f_size) { curr_img_bit = ++i; curr_encoded_bit = j; break; }
-        }
-
-        // get extension for filename
-        std::string ext = ".";
-        for (int i=0; i<h.extension.size(); i++)
-            ext += bs2b(h.extension[i]);
-
-        // report
-        std::cout<<"---------------------------\n";
-        std::cout<<"Decrypted with header info:\n";
-        std::cout<<"\tCode:\t\t"<<h.code.to_ulong()<<"\n";
-        std::cout<<"\tLeast bits:\t"<<lsbs<<" bits\n";
-        std::cout<<"\tSource Width:\t"<<h.width.to_ulong()<<" px\n";
-        std::cout<<"\tSource Height:\t"<<h.height.to_ulong()<<" px\n";
-        std::cout<<"\tExtension:\t"<<ext<<"\n";
-        std::cout<<"\tData Size:\t"<<f_size<<" bits\n";
-        std::cout<<"\tSeparator:\t"<<bs2b(h.separator)<<"\n";
-        std::cout<<"---------------------------\n";
-
-        //
-        //  Write decrypted file
-        //
-
-        // make the filename
-        std::string fname = "decrypted" + ext;
-
-        // open binary mode
-        std::ofstream ofs(fname.c_str(), std::ios::binary | std::ios::out);
-
-        // abort if failed to open
-        if (!ofs) {
-            std::cout << "ERROR: Data file could not be written to." << std::endl;
-            return;
-        }
-
-        // loop through each bit in data & write it to the output file stream
-        std::bitset<8> f_byte;
-        for (int i=0; i<f_data.size(); i++) {
-            int bit = i % 8;
-            f_byte[bit] = f_data[i];
-            if (bit == 7)
-                ofs.put(bs2b(f_byte));
-        }
-
-        // close the filestream
-        ofs.flush();
-        ofs.close();
-
-        // exception if something went wrong
-        if (ofs.bad()) {
-            std::cout << "ERROR: Data file could not be written properly." << std::endl;
-            return;
-        } else {
-            std::cout << "Decryption successful; saved as \"decrypted"<<ext<<"\"." << std::endl;
-        }
-    }
-} // end of namespace
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       File2ImageStegoTools.cpp
+//  Date:           04/20/2018
+//  Description:    Main implementation for Stenography: File-to-Image Tools namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "File2ImageStegoTools.h"
+#include "StegoKernels.h"
+#include "BmpCarrier.h"
+#include "StegoWorkers.h"
+#include "StegoCompress.h"
+#include "StegoCipher.h"
+#include "StegoChecksum.h"
+#include "StegoPng.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <bitset>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <sys/stat.h>
+#include "math.h"
+#include "CImg.h"
+
+namespace f2i_stego_tools {
+
+    //
+    // structures
+    //
+
+    struct Header {
+        std::bitset<32> f_size;                 // number bits file data is taking up
+        std::bitset<11> h_size;                 // number bits header is taking up
+        std::bitset<3> lsbs;                    // least significant bits
+        std::bitset<2> code;                    // "11" = file to image encryption
+        std::bitset<8> separator;               // separates header expressions
+        std::bitset<8> separator2;              // separates header expressions (backup just in case)
+        std::bitset<11> width;                  // width of image
+        std::bitset<11> height;                 // height of image
+        std::vector<std::bitset<8> > extension; // extension of data file
+    };
+
+    // version 2 header (code "10"): fixed-width fields, no separators to scan
+    // for; version 1 headers are read into this form as well
+    struct HeaderV2 {
+        int code;                               // "10" = version 2, "11" = version 1
+        int lsbs;                               // least significant bits
+        int flags;                              // optional fields that follow (FLAG_*)
+        unsigned long width;                    // width of image (32 bits)
+        unsigned long height;                   // height of image (32 bits)
+        unsigned long long f_bytes;             // number of bytes in the data file (64 bits)
+        std::string extension;                  // extension of data file (8 bit length first)
+        Shard shard;                            // FLAG_SHARD: index(16), count(16), id(64), offset(64)
+        unsigned long long raw_bytes;           // FLAG_COMPRESSED: data file bytes before deflate (64)
+        unsigned long long nonce;               // FLAG_KEYED: keystream nonce (64)
+        unsigned int checksum;                  // FLAG_CHECKSUM: CRC32C of the data as stored (32)
+        unsigned long long h_size;              // number bits header is taking up
+    };
+
+    const int CODE_V1 = 3;
+    const int CODE_V2 = 2;
+
+    // bits in a version 2 header after code and lsbs, not counting the extension:
+    // separator, flags, width, height, f_bytes, extension length
+    const int V2_FIXED_BITS = 8+8+32+32+64+8;
+
+    // flags of a version 2 header; each set flag adds its fields after the extension
+    const int FLAG_SHARD = 1;
+    const int FLAG_COMPRESSED = 2;
+    const int FLAG_KEYED = 4;
+    const int FLAG_CHECKSUM = 8;
+
+    // layout flags add no fields: the stream runs through R,G,B,A instead of
+    // R,G,B (FLAG_ALPHA) and through the low bytes of 16-bit samples (FLAG_DEEP)
+    const int FLAG_ALPHA = 16;
+    const int FLAG_DEEP = 32;
+    const int LAYOUT_FLAGS = FLAG_ALPHA | FLAG_DEEP;
+    const int KNOWN_FLAGS = FLAG_SHARD | FLAG_COMPRESSED | FLAG_KEYED | FLAG_CHECKSUM | LAYOUT_FLAGS;
+
+    // bits of the shard fields: index, count, payload ID, offset
+    const int SHARD_BITS = 16+16+64+64;
+
+    // bits of the compression field: size before compression
+    const int COMPRESS_BITS = 64;
+
+    // bits of the keystream field: nonce
+    const int KEYED_BITS = 64;
+
+    // bits of the checksum field: CRC32C
+    const int CHECKSUM_BITS = 32;
+
+    // bits of the optional fields the flags call for
+    int optional_bits(int flags) {
+        return (flags & FLAG_SHARD ? SHARD_BITS : 0) + (flags & FLAG_COMPRESSED ? COMPRESS_BITS : 0) +
+               (flags & FLAG_KEYED ? KEYED_BITS : 0) + (flags & FLAG_CHECKSUM ? CHECKSUM_BITS : 0);
+    }
+
+    // layout flags of a view's channels and sample depth
+    int layout_flags(const RGBView& view) {
+        return (view.channels() == 4 ? FLAG_ALPHA : 0) | (view.sample_bits() == 16 ? FLAG_DEEP : 0);
+    }
+
+    // most least significant bits a view's samples can give up: all 8 bits
+    // of the low byte of a 16-bit sample, 7 of an 8-bit one
+    int max_lsbs(const RGBView& view) {
+        return view.sample_bits() == 16 ? 8 : 7;
+    }
+
+    //
+    // RGBView
+    //
+
+    // offset of the least significant byte within a T in memory
+    template<class T> int low_byte() {
+        const T one = 1;
+        return *(const unsigned char*)&one == 1 ? 0 : (int)sizeof(T) - 1;
+    }
+
+    template<class T>
+    RGBView::RGBView(cimg_library::CImg<T>& img, bool alpha)
+        : origin((unsigned char*)img.data() + low_byte<T>()), w(img.width()),
+          c_step((long)(img.width()*img.height()*sizeof(T))), x_step((long)sizeof(T)),
+          y_step((long)(img.width()*sizeof(T))), ch(alpha && img.spectrum() >= 4 ? 4 : 3),
+          bits((int)sizeof(T)*8) {
+        n = (unsigned long long)img.width()*img.height()*ch;
+    }
+
+    template RGBView::RGBView(cimg_library::CImg<unsigned char>&, bool);
+    template RGBView::RGBView(cimg_library::CImg<unsigned short>&, bool);
+
+    RGBView::RGBView(unsigned char* origin, int w, int h, long c_step, long x_step, long y_step,
+                     int channels, int sample_bits)
+        : origin(origin), w(w), c_step(c_step), x_step(x_step), y_step(y_step),
+          n((unsigned long long)w*h*channels), ch(channels), bits(sample_bits) {
+    }
+
+    RGBView RGBView::rgb() const {
+        return RGBView(origin, (int)w, (int)height(), c_step, x_step, y_step, 3, bits);
+    }
+
+    template<int C>
+    void RGBView::gather_px(unsigned long long first, unsigned long count,
+                            unsigned char* out) const {
+        unsigned long long x = (first / C) % w;
+        int c = (int)(first % C);
+        const unsigned char* px = at(first) - c*c_step;
+        for (unsigned long i=0; i<count; i++) {
+            out[i] = px[c*c_step];
+            if (++c == C) {
+                c = 0;
+                px += x_step;
+                // next row
+                if (++x == w) { x = 0; px += y_step - (long long)w*x_step; }
+            }
+        }
+    }
+
+    template<int C>
+    void RGBView::scatter_px(unsigned long long first, unsigned long count,
+                             const unsigned char* in) {
+        unsigned long long x = (first / C) % w;
+        int c = (int)(first % C);
+        unsigned char* px = at(first) - c*c_step;
+        for (unsigned long i=0; i<count; i++) {
+            px[c*c_step] = in[i];
+            if (++c == C) {
+                c = 0;
+                px += x_step;
+                // next row
+                if (++x == w) { x = 0; px += y_step - (long long)w*x_step; }
+            }
+        }
+    }
+
+    void RGBView::gather(unsigned long long first, unsigned long count,
+                         unsigned char* out) const {
+        if (count == 0) return;
+        if (ch == 4) gather_px<4>(first, count, out);
+        else gather_px<3>(first, count, out);
+    }
+
+    void RGBView::scatter(unsigned long long first, unsigned long count,
+                          const unsigned char* in) {
+        if (count == 0) return;
+        if (ch == 4) scatter_px<4>(first, count, in);
+        else scatter_px<3>(first, count, in);
+    }
+
+    //
+    // functions
+    //
+
+    int s2i(std::string str) {
+        // converts string to int
+        std::stringstream ss(str);
+        int i;
+        ss >> i;
+        return i;
+    }
+
+    std::string i2s (int i) {
+        // converts int to string
+        std::stringstream ss;
+        std::string str;
+        ss << i;
+        ss >> str;
+        return str;
+    }
+
+    unsigned int b2ui(unsigned char c) {
+
+        // convert character byte into binary int
+        std::bitset<8> binary(c);
+        return (unsigned int)(binary.to_ulong());
+    }
+
+    unsigned char ui2b(unsigned int i) {
+
+        // convert binary int into character byte
+        std::bitset<8> binary(i);
+        return (unsigned char)(binary.to_ulong());
+    }
+
+    unsigned int bs2ui(std::bitset<8>& byte) {
+
+        // convert byte into int value
+        return (unsigned int)(byte.to_ulong());
+    }
+
+    unsigned char bs2b(std::bitset<8> binary) {
+
+        // static cast bitset to u-char
+        return static_cast<unsigned char>(binary.to_ulong());
+    }
+
+    std::bitset<8> s2bs(std::string s) {
+
+        // place binary string into a bitset
+        return std::bitset<8>(s);
+    }
+
+    std::bitset<8> ui2bs(unsigned int i) {
+
+        // place binary int into a bitset
+        return std::bitset<8> (i);
+    }
+
+    std::bitset<8> b2bs(unsigned char c) {
+
+        // place binary character into a bitset
+        return std::bitset<8> (c);
+    }
+
+    std::vector<std::bitset<8> > get_data_from_img(cimg_library::CImg<unsigned char>& img) {
+        std::vector<std::bitset<8> > bytes;
+        for (int y=0; y<img.height(); y++) {
+            for (int x=0; x<img.width(); x++) {
+                bytes.push_back(b2bs(img(x,y,0))); //R
+                bytes.push_back(b2bs(img(x,y,1))); //G
+                bytes.push_back(b2bs(img(x,y,2))); //B
+            }
+        }
+
+        return bytes;
+    }
+
+    std::vector<std::bitset<8> > get_extension_data(std::string f) {
+        std::vector<std::bitset<8> > bytes;
+        std::string::size_type index = f.find_last_of(".");
+        if (index == std::string::npos) return bytes;
+        std::string ext = f.substr(index);
+        for (int i=1; i<ext.size(); i++) {  // skip the "." character
+            bytes.push_back(b2bs(ext[i]));
+        }
+        return bytes;
+    }
+
+    Header create_header_data(cimg_library::CImg<unsigned char>& img,
+                              std::vector<std::bitset<8> >& e, int code,
+                              int bits, std::vector<std::bitset<8> >& fdata){
+        return create_header_data(img, e, code, bits, (unsigned long)fdata.size());
+    }
+
+    Header create_header_data(cimg_library::CImg<unsigned char>& img,
+                              std::vector<std::bitset<8> >& e, int code,
+                              int bits, unsigned long f_bytes){
+        Header h;
+        h.width = std::bitset<11> (img.width());
+        h.height = std::bitset<11> (img.height());
+        h.code = std::bitset<2> (i2s(code));
+        h.lsbs = std::bitset<3> (bits);
+        h.separator = std::bitset<8>('x');
+        h.separator2 = std::bitset<8>('\n');
+        h.extension = e;
+        // code,least significant bits,x,width,x,height,x,f_size,x,extension,x,
+        h.h_size = std::bitset<11>(2+3+8+11+8+11+8+32+8+(e.size()*8)+8);
+        // number of bits making up the data file to encrypt
+        h.f_size = std::bitset<32>(f_bytes*8);
+        return h;
+    }
+
+    //
+    // embed engine
+    //
+
+    // longest header in bytes: a version 2 header with a 255 character extension
+    const int MAX_HEADER_BYTES = (2 + 3 + V2_FIXED_BITS + 8*255 + SHARD_BITS + COMPRESS_BITS + KEYED_BITS +
+                                 CHECKSUM_BITS + 7) / 8;
+
+    // packs header fields into a little-endian bit stream (bit 0 of each field
+    // first), which is the order they are written into the image
+    struct BitPacker {
+        unsigned char bytes[MAX_HEADER_BYTES];
+        unsigned long long bits;
+        BitPacker() : bits(0) { memset(bytes, 0, sizeof(bytes)); }
+        void put(unsigned long long value, int n) {
+            for (int i=0; i<n; i++, bits++) {
+                if ((value >> i) & 1) bytes[bits / 8] |= (unsigned char)(1 << (bits % 8));
+            }
+        }
+    };
+
+    HeaderV2 create_header_v2(unsigned long width, unsigned long height, std::string ext,
+                              int bits, unsigned long long f_bytes, const Shard& shard,
+                              bool compressed, const Keystream* key, int layout) {
+        HeaderV2 h;
+        h.code = CODE_V2;
+        h.lsbs = bits;
+        h.flags = (shard.count > 0 ? FLAG_SHARD : 0) | (compressed ? FLAG_COMPRESSED : 0) |
+                  (key ? FLAG_KEYED : 0) | FLAG_CHECKSUM | layout;
+        h.width = width;
+        h.height = height;
+        h.f_bytes = f_bytes;
+        h.extension = ext;
+        h.shard = shard;
+        h.raw_bytes = f_bytes;
+        h.nonce = key ? key->nonce() : 0;
+        h.checksum = 0;
+        h.h_size = 2 + 3 + V2_FIXED_BITS + 8*ext.size() + optional_bits(h.flags);
+        return h;
+    }
+
+    BitPacker pack_header(HeaderV2& h) {
+        BitPacker p;
+        p.put(h.code, 2);
+        p.put(h.lsbs & 7, 3);   // 8 (16-bit samples only) is stored as 0
+        p.put('x', 8);
+        p.put(h.flags, 8);
+        p.put(h.width, 32);
+        p.put(h.height, 32);
+        p.put(h.f_bytes, 64);
+        p.put(h.extension.size(), 8);
+        for (int i=0; i<(int)h.extension.size(); i++)
+            p.put((unsigned char)h.extension[i], 8);
+        if (h.flags & FLAG_SHARD) {
+            p.put(h.shard.index, 16);
+            p.put(h.shard.count, 16);
+            p.put(h.shard.payload_id, 64);
+            p.put(h.shard.offset, 64);
+        }
+        if (h.flags & FLAG_COMPRESSED)
+            p.put(h.raw_bytes, 64);
+        if (h.flags & FLAG_KEYED)
+            p.put(h.nonce, 64);
+        if (h.flags & FLAG_CHECKSUM)
+            p.put(h.checksum, 32);
+        return p;
+    }
+
+    // the code and lsbs fields (first 5 stream bits) live in the lowest bits of
+    // the first 4 image bytes; every byte after that carries lsbs stream bits
+    const int FIXED_BITS = 5;
+    const int FIXED_BYTES = 4;
+
+    // image bytes are gathered into chunks of this size before the kernels run
+    const unsigned long CHUNK = 4096;
+
+    // number of image bytes touched by a stream of the given length
+    unsigned long long stream_bytes(unsigned long long bits, int lsbs) {
+        if (bits <= 2) return 1;
+        if (bits <= FIXED_BITS) return bits - 1;
+        return FIXED_BYTES + (bits - FIXED_BITS + lsbs - 1) / lsbs;
+    }
+
+    // returns the interleaved image byte holding stream bit pos
+    inline unsigned long long locate(unsigned long long pos, int lsbs, int& bit) {
+        if (pos < 2) { bit = (int)pos; return 0; }
+        if (pos < FIXED_BITS) { bit = 0; return pos - 1; }
+        bit = (int)((pos - FIXED_BITS) % lsbs);
+        return FIXED_BYTES + (pos - FIXED_BITS) / lsbs;
+    }
+
+    // reads n (<= 8) bits of src like read_bits, XORed with the keystream
+    // (if any) at byte key_pos of src[0]
+    inline unsigned int read_keyed(const unsigned char* src, unsigned long long s, int n,
+                                   const Keystream* key, unsigned long long key_pos) {
+        if (!key) return read_bits(src, s, n);
+        unsigned char b[2] = {0, 0};
+        unsigned long len = (s & 7) + n > 8 ? 2 : 1;
+        memcpy(b, src + s/8, len);
+        key->apply(b, len, key_pos + s/8);
+        return read_bits(b, s & 7, n);
+    }
+
+    // embeds nbits bits of src (starting at bit src_pos) into the image, starting
+    // at stream bit pos; with a keystream, src[0] is XORed with keystream byte
+    // key_pos and so on, a chunk at a time on the way into the kernels. With
+    // crc, it receives the CRC32C of the src bytes (as stored, i.e. keyed)
+    // whose first bit is in the range, taken chunk by chunk as well
+    void embed_bits(RGBView& view, int lsbs, unsigned long long pos, const unsigned char* src,
+                    unsigned long long src_pos, unsigned long long nbits,
+                    const Keystream* key=NULL, unsigned long long key_pos=0,
+                    unsigned int* crc=NULL) {
+        unsigned long long s = src_pos; // current bit in src
+        unsigned long long done = (src_pos + 7) / 8; // next src byte to checksum
+        unsigned int sum = 0;
+        nbits += src_pos;
+        unsigned char b;
+        int bit;
+
+        // checksums the src bytes starting before bit at, keying a copy
+        // of them first (only a byte or so at either end of the range)
+        auto checksum_to = [&](unsigned long long at) {
+            unsigned char k[8];
+            for (unsigned long long end = (at + 7) / 8; done < end; ) {
+                unsigned long n = (unsigned long)std::min<unsigned long long>(end - done, sizeof(k));
+                memcpy(k, src + done, n);
+                if (key) key->apply(k, n, key_pos + done);
+                sum = crc32c(sum, k, n);
+                done += n;
+            }
+        };
+
+        // fixed header bits and a partially filled leading byte, bit by bit
+        while (s < nbits && (pos < FIXED_BITS || (pos - FIXED_BITS) % lsbs != 0)) {
+            unsigned long long byte = locate(pos, lsbs, bit);
+            view.gather(byte, 1, &b);
+            b = (b & ~(1 << bit)) | (read_keyed(src, s, 1, key, key_pos) << bit);
+            view.scatter(byte, 1, &b);
+            pos++; s++;
+        }
+        if (crc) checksum_to(s);
+
+        // whole bytes, a chunk at a time
+        unsigned long long first = locate(pos, lsbs, bit);
+        unsigned long long whole = (nbits - s) / lsbs;
+        unsigned char buf[CHUNK];
+        unsigned char keyed[CHUNK + 1]; // src bytes of a chunk (one more at lsbs 8), XORed with the keystream
+        while (whole > 0) {
+            unsigned long n = (unsigned long)(whole < CHUNK ? whole : CHUNK);
+            unsigned long long lo = s / 8, hi = (s + (unsigned long long)n*lsbs + 7) / 8;
+            view.gather(first, n, buf);
+            if (key) {
+                memcpy(keyed, src + lo, (size_t)(hi - lo));
+                key->apply(keyed, (unsigned long)(hi - lo), key_pos + lo);
+                best_kernels().embed[lsbs](buf, n, keyed, s & 7);
+            } else {
+                best_kernels().embed[lsbs](buf, n, src, s);
+            }
+            view.scatter(first, n, buf);
+            if (crc && hi > done) {
+                sum = crc32c(sum, key ? keyed + (done - lo) : src + done, (unsigned long)(hi - done));
+                done = hi;
+            }
+            first += n; whole -= n;
+            s += (unsigned long long)n * lsbs; pos += (unsigned long long)n * lsbs;
+        }
+
+        // trailing partial byte
+        if (s < nbits) {
+            int n = (int)(nbits - s);
+            unsigned char mask = (unsigned char)((1 << n) - 1);
+            view.gather(first, 1, &b);
+            b = (b & ~mask) | read_keyed(src, s, n, key, key_pos);
+            view.scatter(first, 1, &b);
+        }
+        if (crc) {
+            checksum_to(nbits);
+            *crc = sum;
+        }
+    }
+
+    // extracts nbits bits starting at stream bit pos out of the image into dst;
+    // with a keystream, dst[0] is XORed with keystream byte key_pos and so on,
+    // each chunk as soon as its bytes are complete. With crc, it receives the
+    // CRC32C of the whole bytes extracted (as stored, before the keystream)
+    void extract_bits(RGBView& view, int lsbs, unsigned long long pos,
+                      unsigned char* dst, unsigned long long nbits,
+                      const Keystream* key=NULL, unsigned long long key_pos=0,
+                      unsigned int* crc=NULL) {
+        unsigned long long s = 0; // current bit in dst
+        unsigned long long done = 0; // bytes of dst already checksummed and XORed
+        unsigned int sum = 0;
+        int bit;
+
+        // checksums and then keys the complete bytes of dst before bit at
+        auto finish_to = [&](unsigned long long at) {
+            if (at/8 <= done) return;
+            unsigned long n = (unsigned long)(at/8 - done);
+            if (crc) sum = crc32c(sum, dst + done, n);
+            if (key) key->apply(dst + done, n, key_pos + done);
+            done = at/8;
+        };
+
+        // fixed header bits and a partially used leading byte, bit by bit
+        while (s < nbits && (pos < FIXED_BITS || (pos - FIXED_BITS) % lsbs != 0)) {
+            unsigned long long byte = locate(pos, lsbs, bit);
+            write_bits(dst, s, view.bit(byte, bit), 1);
+            pos++; s++;
+        }
+
+        // whole bytes, a chunk at a time
+        unsigned long long first = locate(pos, lsbs, bit);
+        unsigned long long whole = (nbits - s) / lsbs;
+        unsigned char buf[CHUNK];
+        while (whole > 0) {
+            unsigned long n = (unsigned long)(whole < CHUNK ? whole : CHUNK);
+            view.gather(first, n, buf);
+            best_kernels().extract[lsbs](buf, n, dst, s);
+            first += n; whole -= n;
+            s += (unsigned long long)n * lsbs; pos += (unsigned long long)n * lsbs;
+            finish_to(s);
+        }
+
+        // trailing partial byte
+        if (s < nbits)
+            write_bits(dst, s, view[first], (int)(nbits - s));
+
+        // what is left, the bits of a partial last byte only
+        finish_to(nbits);
+        if (key && nbits % 8) {
+            unsigned char k = 0;
+            key->apply(&k, 1, key_pos + nbits/8);
+            dst[nbits/8] ^= k & ((1 << (nbits % 8)) - 1);
+        }
+        if (crc) *crc = sum;
+    }
+
+    // smallest number of image bytes worth handing to another thread
+    const unsigned long long MIN_BAND = 1 << 20;
+
+    // most bands one embed/extract is split into
+    const int MAX_BANDS = 256;
+
+    // number of bands to split n image bytes into (threads <= 0: one per core)
+    int band_count(unsigned long long bytes, int threads) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+        if (threads > MAX_BANDS) threads = MAX_BANDS;
+        unsigned long long most = bytes / MIN_BAND;
+        if (most < (unsigned long long)threads) threads = most > 0 ? (int)most : 1;
+        return threads;
+    }
+
+    // splits the stream bits [pos, pos+nbits) into row bands for separate
+    // threads; bands meet on image byte boundaries so no two threads touch the
+    // same byte
+    struct EmbedBands {
+        int lsbs, count;
+        unsigned long long pos, nbits, start, whole;
+
+        EmbedBands(int lsbs, unsigned long long pos, unsigned long long nbits, int threads)
+            : lsbs(lsbs), pos(pos), nbits(nbits) {
+            count = band_count(stream_bytes(pos + nbits, lsbs) - stream_bytes(pos, lsbs), threads);
+            if (pos + nbits <= FIXED_BITS) count = 1;
+
+            // first stream bit at the start of a whole image byte, and the whole bytes after it
+            start = pos < FIXED_BITS ? FIXED_BITS : pos + (lsbs - (pos - FIXED_BITS) % lsbs) % lsbs;
+            whole = start < pos + nbits ? (pos + nbits - start) / lsbs : 0;
+        }
+
+        // stream bits of band k
+        void range(int k, unsigned long long& begin, unsigned long long& end) const {
+            begin = k == 0 ? pos : start + lsbs * (whole * k / count);
+            end = k == count-1 ? pos + nbits : start + lsbs * (whole * (k+1) / count);
+        }
+    };
+
+    // CRCs of consecutive bands, put together in order once they are all done
+    struct BandSums {
+        unsigned int crc[MAX_BANDS];
+        unsigned long long bytes[MAX_BANDS];
+
+        unsigned int combine(int count) const {
+            unsigned int sum = crc[0];
+            for (int k=1; k<count; k++) sum = crc32c_combine(sum, crc[k], bytes[k]);
+            return sum;
+        }
+    };
+
+    // embed_bits split into bands run on the workers; crc as for embed_bits,
+    // over every byte of src
+    void embed_bits_parallel(RGBView& view, int lsbs, unsigned long long pos,
+                             const unsigned char* src, unsigned long long nbits,
+                             int threads, Workers& workers, const Keystream* key=NULL,
+                             unsigned int* crc=NULL) {
+        EmbedBands bands(lsbs, pos, nbits, threads);
+        BandSums sums;
+        auto band = [&](int k) {
+            unsigned long long begin, end;
+            bands.range(k, begin, end);
+            sums.bytes[k] = (end - pos + 7) / 8 - (begin - pos + 7) / 8;
+            embed_bits(view, lsbs, begin, src, begin - pos, end - begin, key, 0,
+                       crc ? &sums.crc[k] : NULL);
+        };
+        workers.run(bands.count, band);
+        if (crc) *crc = sums.combine(bands.count);
+    }
+
+    // extract_bits split into bands run on the workers; bands meet on byte
+    // boundaries of dst so no two threads write the same byte
+    void extract_bits_parallel(RGBView& view, int lsbs, unsigned long long pos,
+                               unsigned char* dst, unsigned long long nbytes,
+                               int threads, Workers& workers,
+                               const Keystream* key=NULL, unsigned long long key_pos=0,
+                               unsigned int* crc=NULL) {
+        int bands = band_count(nbytes * 8 / lsbs, threads);
+        BandSums sums;
+        auto band = [&](int k) {
+            unsigned long long begin = nbytes * k / bands, end = nbytes * (k+1) / bands;
+            sums.bytes[k] = end - begin;
+            sums.crc[k] = 0;
+            if (end > begin)
+                extract_bits(view, lsbs, pos + begin*8, dst + begin, (end - begin)*8,
+                             key, key_pos + begin, crc ? &sums.crc[k] : NULL);
+        };
+        workers.run(bands, band);
+        if (crc) *crc = sums.combine(bands);
+    }
+
+    // resizes a pooled buffer, counting the times it has to grow
+    void fit(std::vector<unsigned char>& buf, unsigned long long n, unsigned long long& grown) {
+        if (n > buf.capacity()) grown++;
+        buf.resize((size_t)n);
+    }
+
+    // data files are read and embedded in blocks of this many bytes
+    const unsigned long IN_BLOCK = 4 << 20;
+
+    // decrypted data is extracted and written in blocks of this many bytes
+    const unsigned long long OUT_BLOCK = 1 << 20;
+
+    // longest extension the 11 bit h_size field can describe
+    const unsigned int MAX_EXTENSION = (2047 - 99) / 8;
+
+    // little-endian integer of n bytes
+    unsigned long long le(const unsigned char* p, int n) {
+        unsigned long long v = 0;
+        for (int i=n-1; i>=0; i--) v = v << 8 | p[i];
+        return v;
+    }
+
+    // reads an nbits (<= 64) wide header field at stream bit pos and moves pos
+    // past it; fields past the end of the image read as 0
+    unsigned long long read_field(RGBView& view, int lsbs, unsigned long long& pos, int nbits) {
+        unsigned char buf[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        if (stream_bytes(pos + nbits, lsbs) <= view.size())
+            extract_bits(view, lsbs, pos, buf, nbits);
+        pos += nbits;
+        return le(buf, 8);
+    }
+
+    // reads a version 1 header: separator-delimited fields, scanned in order
+    bool read_header_v1(RGBView& view, HeaderV2& out) {
+        Header h;
+        int lsbs = out.lsbs;
+
+        // bits >> separator #1
+        unsigned long long pos = FIXED_BITS; // current encoded bit
+        h.separator = read_field(view, lsbs, pos, 8);
+        if (bs2b(h.separator) != 'x') return false;
+
+        // bits >> width, separator #2, height
+        h.width = read_field(view, lsbs, pos, 11);
+        h.separator = read_field(view, lsbs, pos, 8);
+        h.height = read_field(view, lsbs, pos, 11);
+        if (bs2b(h.separator) != 'x') return false;
+
+        // bits >> separator #3, extension, separator #4
+        h.separator = read_field(view, lsbs, pos, 8);
+        for (;;) {
+            std::bitset<8> e = read_field(view, lsbs, pos, 8);
+            if (bs2b(e) == '\n') break;
+            h.extension.push_back(e);
+            // the 11 bit header size leaves room for at most this many characters
+            if (h.extension.size() > MAX_EXTENSION) return false;
+        }
+        if (bs2b(h.separator) != 'x') return false;
+
+        // bits >> f_size, separator #5
+        h.f_size = read_field(view, lsbs, pos, 32);
+        h.separator = read_field(view, lsbs, pos, 8);
+        if (bs2b(h.separator) != 'x') return false;
+
+        out.flags = 0;
+        out.shard = Shard();
+        out.width = h.width.to_ulong();
+        out.height = h.height.to_ulong();
+        out.f_bytes = h.f_size.to_ulong() / 8;
+        out.raw_bytes = out.f_bytes;
+        out.nonce = 0;
+        out.checksum = 0;
+        out.extension.clear();
+        for (int i=0; i<(int)h.extension.size(); i++)
+            out.extension += bs2b(h.extension[i]);
+        out.h_size = pos;
+        return true;
+    }
+
+    // reads a version 2 header: every field at a fixed offset, so the fixed
+    // part and then the extension each come out in one extract
+    bool read_header_v2(RGBView& view, HeaderV2& out) {
+        int lsbs = out.lsbs;
+        unsigned char f[V2_FIXED_BITS / 8];
+        if (stream_bytes(FIXED_BITS + V2_FIXED_BITS, lsbs) > view.size()) return false;
+        extract_bits(view, lsbs, FIXED_BITS, f, V2_FIXED_BITS);
+        if (f[0] != 'x' || (f[1] & ~KNOWN_FLAGS) != 0) return false;
+        if ((f[1] & LAYOUT_FLAGS) != layout_flags(view)) return false;
+
+        out.flags = f[1];
+        out.width = (unsigned long)le(f+2, 4);
+        out.height = (unsigned long)le(f+6, 4);
+        out.f_bytes = le(f+10, 8);
+        int ext_len = f[18];
+        int opt_bits = optional_bits(out.flags);
+        out.h_size = FIXED_BITS + V2_FIXED_BITS + 8*ext_len + opt_bits;
+        if (stream_bytes(out.h_size, lsbs) > view.size()) return false;
+
+        // extension, then the optional fields
+        unsigned char ext[256 + (SHARD_BITS + COMPRESS_BITS + KEYED_BITS + CHECKSUM_BITS)/8];
+        extract_bits(view, lsbs, FIXED_BITS + V2_FIXED_BITS, ext, 8*ext_len + opt_bits);
+        out.extension.assign((const char*)ext, ext_len);
+        out.shard = Shard();
+        out.raw_bytes = out.f_bytes;
+        const unsigned char* o = ext + ext_len;
+        if (out.flags & FLAG_SHARD) {
+            out.shard.index = (int)le(o, 2);
+            out.shard.count = (int)le(o+2, 2);
+            out.shard.payload_id = le(o+4, 8);
+            out.shard.offset = le(o+12, 8);
+            if (out.shard.count == 0 || out.shard.index >= out.shard.count) return false;
+            o += SHARD_BITS/8;
+        }
+        if (out.flags & FLAG_COMPRESSED) {
+            out.raw_bytes = le(o, 8);
+            if (out.raw_bytes > max_inflated(out.f_bytes)) return false;
+            o += COMPRESS_BITS/8;
+        }
+        out.nonce = 0;
+        if (out.flags & FLAG_KEYED) {
+            out.nonce = le(o, 8);
+            o += KEYED_BITS/8;
+        }
+        out.checksum = out.flags & FLAG_CHECKSUM ? (unsigned int)le(o, 4) : 0;
+        return true;
+    }
+
+    // reads either header version from the image and checks it against the
+    // image dimensions (and a version 2 header against the view's layout)
+    bool read_header(RGBView& view, unsigned long width, unsigned long height, HeaderV2& h) {
+        if (view.size() < FIXED_BYTES) return false;
+
+        // bits >> code, lsbs
+        // first 4 bytes contain the code and least significant bit amount
+        h.code = view.bit(0, 0) | view.bit(0, 1) << 1;
+        h.lsbs = view.bit(1, 0) | view.bit(2, 0) << 1 | view.bit(3, 0) << 2;
+        if (h.lsbs == 0 && h.code == CODE_V2) h.lsbs = 8;
+        if (h.lsbs < 1 || h.lsbs > max_lsbs(view)) return false;
+
+        // version 1 headers only ever went into 8-bit R,G,B
+        bool ok = false;
+        if (h.code == CODE_V1) ok = layout_flags(view) == 0 && read_header_v1(view, h);
+        else if (h.code == CODE_V2) ok = read_header_v2(view, h);
+        return ok && h.width == width && h.height == height;
+    }
+
+    // prints how the encryption bits compare to what the image can hold;
+    // returns false if they do not fit
+    bool report_fit(long long total_bits, long long bytes_available, int least_significant_bits,
+                    int channels=3) {
+        long long bytes_needed = stream_bytes(total_bits, least_significant_bits);
+        long long result = bytes_available - bytes_needed;
+        long long result_bits = bytes_available*least_significant_bits - total_bits;
+        std::cout<<"("<<total_bits<<" encryption bits/"<<bytes_available*8<<" image bits/"<<least_significant_bits<<" least significant bits)"<<std::endl;
+        if (result < 0) {
+            std::cout<<"ERROR: Data file is too large/image file is too small."<<std::endl;
+            std::cout<<-1*result<<" bytes ("<<-1*result_bits<<" bits or "<<-1*result/channels<<" pixels) are needed to encrypt the given image."<<std::endl;
+            return false;
+        } else {
+            std::cout<<"There is a surplus of "<<result<<" bytes ("<<result_bits<<" bits or "<<result/channels<<" pixels) in the image."<<std::endl;
+            return true;
+        }
+    }
+
+    // prints how well the data file compressed and what that leaves room for
+    void report_compression(const Result& r) {
+        double ratio = r.f_bytes ? (double)r.raw_bytes / r.f_bytes : 1.0;
+        long long surplus = ((long long)r.bytes_available*r.lsbs - (long long)r.bits) / 8;
+        std::cout<<"Compressed "<<r.raw_bytes<<" bytes to "<<r.f_bytes<<" bytes (ratio "<<ratio<<":1); ";
+        std::cout<<"at that ratio the image holds about "<<(long long)(surplus > 0 ? surplus*ratio : 0)
+                 <<" more bytes of data."<<std::endl;
+    }
+
+    // size of a stream in bytes if it can be found without reading it
+    // (regular files), -1 otherwise (pipes, standard input)
+    long long stream_size(std::istream& in) {
+        std::streampos here = in.tellg();
+        if (here == std::streampos(-1) || !in.seekg(0, std::ios::end)) {
+            in.clear();
+            return -1;
+        }
+        long long size = (long long)(in.tellg() - here);
+        in.seekg(here);
+        return size;
+    }
+
+    // extension of a data file as it is stored in the header
+    std::string header_extension(std::string file_filename) {
+        std::vector<std::bitset<8> > extension = get_extension_data(file_filename);
+        std::string ext;
+        for (int i=0; i<(int)extension.size() && i<255; i++)
+            ext += bs2b(extension[i]);
+        return ext;
+    }
+
+    bool image_size(std::string img_filename, int& width, int& height) {
+        unsigned char b[26];
+        std::ifstream ifs(img_filename.c_str(), std::ios::binary|std::ios::in);
+        if (!ifs.read((char*)b, sizeof(b))) return false;
+
+        // BMP: file header, then the size of the info header; the old 12 byte
+        // core header has 16-bit dimensions, the others 32-bit ones (a
+        // negative height means the rows are stored top-down)
+        if (b[0] == 'B' && b[1] == 'M') {
+            if (le(b+14, 4) == 12) {
+                width = (int)le(b+18, 2);
+                height = (int)le(b+20, 2);
+            } else {
+                width = (int)le(b+18, 4);
+                height = (int)(unsigned int)le(b+22, 4);
+                if (height < 0) height = -height;
+            }
+            return width > 0 && height > 0;
+        }
+
+        // PNG: signature, then the IHDR chunk with big-endian dimensions
+        static const unsigned char png[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        if (memcmp(b, png, 8) == 0 && memcmp(b+12, "IHDR", 4) == 0) {
+            width = (int)(b[16]<<24 | b[17]<<16 | b[18]<<8 | b[19]);
+            height = (int)(b[20]<<24 | b[21]<<16 | b[22]<<8 | b[23]);
+            return width > 0 && height > 0;
+        }
+        return false;
+    }
+
+    long long file_size(std::string filename) {
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0) return -1;
+        return (long long)st.st_size;
+    }
+
+    bool image_format(std::string img_filename, int& width, int& height, int& channels, int& sample_bits) {
+        if (!image_size(img_filename, width, height)) return false;
+        channels = 3;
+        sample_bits = 8;
+
+        // PNG: bit depth and color type follow the dimensions in IHDR
+        unsigned char b[26];
+        std::ifstream ifs(img_filename.c_str(), std::ios::binary|std::ios::in);
+        if (!ifs.read((char*)b, sizeof(b)) || b[0] != 0x89) return true;
+        int color = b[25];
+        if (b[24] == 16) sample_bits = 16;
+        if (color == 4 || color == 6) channels = 4;
+        if (color != 0 && color != 2 && color != 3) return true;
+
+        // a tRNS chunk (before the image data) gives gray and RGB images an
+        // alpha channel when it holds their key, and palette images when any
+        // entry is not opaque, as read_png() decodes them
+        ifs.seekg(8 + 8 + 13 + 4);
+        unsigned char chunk[8];
+        while (ifs.read((char*)chunk, sizeof(chunk))) {
+            unsigned long n = (unsigned long)chunk[0] << 24 | chunk[1] << 16 | chunk[2] << 8 | chunk[3];
+            if (memcmp(chunk+4, "IDAT", 4) == 0 || memcmp(chunk+4, "IEND", 4) == 0) break;
+            if (memcmp(chunk+4, "tRNS", 4) == 0) {
+                std::vector<unsigned char> trns(n);
+                if (n > 256 || (n && !ifs.read((char*)&trns[0], n))) break;
+                if (color == 0) channels = n >= 2 ? 4 : 3;
+                else if (color == 2) channels = n >= 6 ? 4 : 3;
+                else channels = std::count(trns.begin(), trns.end(), 255) < (long)n ? 4 : 3;
+                break;
+            }
+            if (!ifs.seekg(n + 4, std::ios::cur)) break;
+        }
+        return true;
+    }
+
+    // capacity() of an image of the given format; -1 if lsbs is out of range
+    long long capacity_of(int width, int height, int channels, int sample_bits,
+                          int least_significant_bits, std::string ext) {
+        if (least_significant_bits < 1 || least_significant_bits > (sample_bits == 16 ? 8 : 7)) return -1;
+
+        // bits the image can hold, less a version 2 header with its checksum
+        unsigned long long bytes = (unsigned long long)width*height*channels;
+        if (bytes < FIXED_BYTES) return 0;
+        unsigned long long bits = FIXED_BITS + (bytes - FIXED_BYTES)*least_significant_bits;
+        unsigned long long h_size = 2 + 3 + V2_FIXED_BITS + 8*ext.size() + CHECKSUM_BITS;
+        return bits < h_size ? 0 : (long long)((bits - h_size) / 8);
+    }
+
+    long long capacity(std::string img_filename, int least_significant_bits, std::string ext, bool png) {
+        int width, height, channels, sample_bits;
+        if (!image_format(img_filename, width, height, channels, sample_bits)) return -1;
+
+        // anything not saved as a PNG is embedded into 8-bit R,G,B, as in encrypt_image()
+        if (!png) {
+            channels = 3;
+            sample_bits = 8;
+        }
+        return capacity_of(width, height, channels, sample_bits, least_significant_bits, ext);
+    }
+
+    bool fits(std::string img_filename, unsigned long long f_bytes,
+              int least_significant_bits, std::string ext, bool png) {
+        long long available = capacity(img_filename, least_significant_bits, ext, png);
+        return available >= 0 && f_bytes <= (unsigned long long)available;
+    }
+
+    bool fits(std::string img_filename, std::string file_filename, int least_significant_bits, bool png) {
+        long long f_bytes = file_size(file_filename);
+        return f_bytes >= 0 &&
+               fits(img_filename, f_bytes, least_significant_bits, header_extension(file_filename), png);
+    }
+
+    //
+    // in-memory encrypt/decrypt
+    //
+
+    Stats::Stats()
+        : read(0), load(0), unpack(0), header(0), embed(0), save(0), write(0), total(0),
+          payload_bytes(0), image_bytes(0), pixels(0), peak_buffer(0) {
+    }
+
+    Result::Result()
+        : status(SUCCESS), code(0), lsbs(0), width(0), height(0), channels(3), sample_bits(8),
+          f_bytes(0), raw_bytes(0), compressed(false), keyed(false), nonce(0),
+          checksummed(false), checksum(0), bits(0), bytes_available(0) {
+    }
+
+    // wall time since it was started or last lapped
+    struct Stopwatch {
+        std::chrono::steady_clock::time_point t;
+
+        Stopwatch() : t(std::chrono::steady_clock::now()) {}
+
+        // seconds since the last lap (or the start), starting the next lap
+        double lap() {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            double s = std::chrono::duration<double>(now - t).count();
+            t = now;
+            return s;
+        }
+
+        // seconds since the last lap (or the start)
+        double elapsed() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+        }
+    };
+
+    // fills in the counters of a result whose bits have been embedded or
+    // extracted, payload bytes of them file data
+    void count_touched(Result& r, unsigned long long payload, unsigned long long bits,
+                       unsigned long long buffer, const Stopwatch& total) {
+        r.stats.payload_bytes = payload;
+        r.stats.image_bytes = r.lsbs > 0 ? stream_bytes(bits, r.lsbs) : 0;
+        r.stats.pixels = (r.stats.image_bytes + r.channels - 1) / r.channels;
+        r.stats.peak_buffer = std::max(r.stats.peak_buffer, buffer);
+        r.stats.total = total.elapsed();
+    }
+
+    // message for data that does not match the checksum in its header
+    const char* const CHECKSUM_MISMATCH = "Checksum mismatch; the data in the image is corrupted.";
+
+    // marks a result as failed
+    Result& fail(Result& r, Status status, std::string message) {
+        r.status = status;
+        r.message = message;
+        return r;
+    }
+
+    // checks the arguments, then embeds a version 2 header for a data file
+    // of f_bytes bytes; fills in what the result knows so far
+    bool begin_encrypt(RGBView& view, unsigned long long f_bytes, std::string ext,
+                       int lsbs, const Shard& shard, bool compressed, const Keystream* key,
+                       HeaderV2& hdata, Result& r) {
+        r.code = CODE_V2;
+        r.lsbs = lsbs;
+        r.width = view.width();
+        r.height = view.height();
+        r.channels = view.channels();
+        r.sample_bits = view.sample_bits();
+        r.extension = ext;
+        r.f_bytes = f_bytes;
+        r.raw_bytes = f_bytes;
+        r.compressed = compressed;
+        r.keyed = key != NULL;
+        r.nonce = key ? key->nonce() : 0;
+        r.checksummed = true;
+        r.shard = shard;
+        r.bytes_available = view.size();
+        if (lsbs < 1 || lsbs > max_lsbs(view)) {
+            fail(r, BAD_ARGUMENT, "Least significant bits must be between 1 and 7 (8 for 16-bit images).");
+            return false;
+        }
+        if (ext.size() > 255) {
+            fail(r, BAD_ARGUMENT, "Extension is longer than 255 characters.");
+            return false;
+        }
+
+        // disallow encryption if file cannot fit into image
+        hdata = create_header_v2(view.width(), view.height(), ext, lsbs, f_bytes, shard, compressed, key,
+                                 layout_flags(view));
+        r.bits = hdata.h_size + f_bytes*8;
+        if (view.size() < FIXED_BYTES || stream_bytes(r.bits, lsbs) > view.size()) {
+            fail(r, TOO_LARGE, "Data file is too large/image file is too small.");
+            return false;
+        }
+
+        // pack header data into a little-endian bit stream and embed it
+        BitPacker header_bits = pack_header(hdata);
+        embed_bits(view, lsbs, 0, header_bits.bytes, 0, header_bits.bits);
+        return true;
+    }
+
+    //
+    // Encoder
+    //
+
+    Encoder::Encoder(int lsbs, int threads, int level)
+        : lsbs(lsbs), threads(threads), level(level), keyed(false), grown(0) {
+        std::random_device rd;
+        nonces.seed(((unsigned long long)rd() << 32) ^ rd() ^
+                    (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+
+    void Encoder::set_key(const unsigned char* key) {
+        keyed = key != NULL;
+        if (key) keystream.set_key(key);
+    }
+
+    const Keystream* Encoder::next_keystream() {
+        if (!keyed) return NULL;
+        keystream.set_nonce(nonces());
+        return &keystream;
+    }
+
+    unsigned long long Encoder::allocations() const {
+        return grown + workers.allocations() + deflater.allocations();
+    }
+
+    Result Encoder::encrypt(RGBView& view, const unsigned char* data, unsigned long long size,
+                            std::string ext, const Shard& shard) {
+
+        // compressed data comes out of the deflater a block at a time
+        if (level > 0) {
+            struct { const unsigned char* p; unsigned long long left; } src = { data, size };
+            return encrypt_stream(view, [&src](unsigned char* buf, unsigned long n) -> long {
+                if (n > src.left) n = (unsigned long)src.left;
+                memcpy(buf, src.p, n);
+                src.p += n;
+                src.left -= n;
+                return (long)n;
+            }, size, ext, shard);
+        }
+
+        Result r;
+        HeaderV2 hdata;
+        Stopwatch total, clock;
+        const Keystream* key = next_keystream();
+        bool ok = begin_encrypt(view, size, ext, lsbs, shard, false, key, hdata, r);
+        r.stats.header = clock.lap();
+        if (!ok) return r;
+
+        // the file data goes right after the header; the header is embedded
+        // again with the data's checksum
+        if (size > 0) {
+            embed_bits_parallel(view, lsbs, hdata.h_size, data, size*8, threads, workers, key,
+                                &hdata.checksum);
+            r.stats.embed = clock.lap();
+            BitPacker header_bits = pack_header(hdata);
+            embed_bits(view, lsbs, 0, header_bits.bytes, 0, header_bits.bits);
+            r.stats.header += clock.lap();
+        }
+        r.checksum = hdata.checksum;
+        count_touched(r, size, r.bits, 0, total);
+        return r;
+    }
+
+    Result Encoder::encrypt_stream(RGBView& view, DataSource source, long long f_known,
+                                   std::string ext, const Shard& shard) {
+        Result r;
+        Stopwatch total, clock;
+
+        // compress on the way in: what gets embedded is the deflater's output,
+        // whose size is only known at the end
+        if (level > 0) {
+            if (!deflater.begin(source, level))
+                return fail(r, BAD_ARGUMENT, "Compression level must be between 1 and 9.");
+            source = [this](unsigned char* buf, unsigned long n) { return deflater.read(buf, n); };
+            f_known = -1;
+        }
+
+        // the size is filled in again once the whole source has been read
+        HeaderV2 hdata;
+        const Keystream* key = next_keystream();
+        bool ok = begin_encrypt(view, f_known < 0 ? 0 : f_known, ext, lsbs, shard, level > 0, key, hdata, r);
+        r.stats.header = clock.lap();
+        if (!ok) return r;
+
+        // file data starting right after the header, a block at a time; the
+        // next block is read while the current one is embedded
+        unsigned long long pos = hdata.h_size;
+        unsigned long long capacity = FIXED_BITS + (view.size() - FIXED_BYTES) * lsbs;
+        fit(block, IN_BLOCK, grown);
+        fit(next, IN_BLOCK, grown);
+        r.stats.peak_buffer = 2ULL * IN_BLOCK;
+        long n = source(&block[0], IN_BLOCK);
+        r.stats.read = clock.lap();
+        while (n > 0) {
+            if (pos + n*8ULL > capacity) {
+                // the rest is read without embedding it, so bits is what the
+                // whole data needs and not just where the image ran out
+                unsigned long long needed = pos + n*8ULL;
+                while ((n = source(&block[0], IN_BLOCK)) > 0) needed += n*8ULL;
+                if (n < 0) return fail(r, READ_FAILED, "Data file could not be opened properly.");
+                r.bits = needed;
+                r.f_bytes = (needed - hdata.h_size) / 8;
+                r.raw_bytes = level > 0 ? deflater.raw_bytes() : r.f_bytes;
+                return fail(r, TOO_LARGE, "Data file is too large/image file is too small.");
+            }
+
+            // the reader is one more task next to the embed bands; each task
+            // times itself, as they run side by side
+            long n_next = 0;
+            EmbedBands bands(lsbs, pos, n*8ULL, threads);
+            BandSums sums;
+            double seconds[MAX_BANDS + 1];
+            auto task = [&](int k) {
+                Stopwatch own;
+                if (k == 0) {
+                    n_next = source(&next[0], IN_BLOCK);
+                    seconds[0] = own.elapsed();
+                    return;
+                }
+                unsigned long long begin, end;
+                bands.range(k-1, begin, end);
+                sums.bytes[k-1] = (end - pos + 7) / 8 - (begin - pos + 7) / 8;
+                embed_bits(view, lsbs, begin, &block[0], begin - pos, end - begin,
+                           key, (pos - hdata.h_size) / 8, &sums.crc[k-1]);
+                seconds[k] = own.elapsed();
+            };
+            workers.run(bands.count + 1, task);
+            r.stats.read += seconds[0];
+            r.stats.embed += *std::max_element(seconds + 1, seconds + bands.count + 1);
+            hdata.checksum = crc32c_combine(hdata.checksum, sums.combine(bands.count), n);
+            pos += n*8ULL;
+            block.swap(next);
+            n = n_next;
+        }
+        if (n < 0) return fail(r, READ_FAILED, "Data file could not be opened properly.");
+
+        // backfill the header with the number of bytes actually read and
+        // their checksum
+        unsigned long long f_bytes = (pos - hdata.h_size) / 8;
+        r.f_bytes = f_bytes;
+        r.raw_bytes = level > 0 ? deflater.raw_bytes() : f_bytes;
+        r.bits = pos;
+        r.checksum = hdata.checksum;
+        hdata.f_bytes = f_bytes;
+        hdata.raw_bytes = r.raw_bytes;
+        clock.lap();
+        BitPacker header_bits = pack_header(hdata);
+        embed_bits(view, lsbs, 0, header_bits.bytes, 0, header_bits.bits);
+        r.stats.header += clock.lap();
+        count_touched(r, f_bytes, pos, r.stats.peak_buffer, total);
+        return r;
+    }
+
+    //
+    // Decoder
+    //
+
+    Decoder::Decoder(int threads)
+        : threads(threads), keyed(false), grown(0) {
+    }
+
+    void Decoder::set_key(const unsigned char* key) {
+        keyed = key != NULL;
+        if (key) keystream.set_key(key);
+    }
+
+    const Keystream* Decoder::keystream_for(Result& r) {
+        if (!r.keyed) return NULL;
+        if (!keyed) {
+            fail(r, BAD_ARGUMENT, "Data file is keyed; a key is needed to decrypt it.");
+            return NULL;
+        }
+        keystream.set_nonce(r.nonce);
+        return &keystream;
+    }
+
+    unsigned long long Decoder::allocations() const {
+        return grown + workers.allocations() + inflater.allocations();
+    }
+
+    Result Decoder::decrypt(RGBView& view) {
+        return decrypt(view, out);
+    }
+
+    // the part of a view a payload was found in: R,G,B alone for carriers
+    // that did not use their alpha channel
+    RGBView payload_view(RGBView& view, const Result& r) {
+        return r.channels < view.channels() ? view.rgb() : view;
+    }
+
+    Result Decoder::decrypt(RGBView& view, std::vector<unsigned char>& dst) {
+        Stopwatch total, clock;
+        Result r = inspect(view);
+        r.stats.header = clock.lap();
+        if (r.status != SUCCESS) return r;
+        RGBView data = payload_view(view, r);
+        const Keystream* key = keystream_for(r);
+        if (r.status != SUCCESS) return r;
+
+        // compressed data is inflated straight into dst
+        if (r.compressed) {
+            fit(dst, r.raw_bytes, grown);
+            unsigned long long at = 0;
+            Result s = decrypt_stream(view, [&](const unsigned char* data, unsigned long n) {
+                if (n > dst.size() - at) return false;
+                memcpy(&dst[at], data, n);
+                at += n;
+                return true;
+            });
+            s.stats.header += r.stats.header;
+            s.stats.peak_buffer += dst.capacity();
+            s.stats.total = total.elapsed();
+            return s;
+        }
+
+        // the file data sits right after the header bits
+        fit(dst, r.f_bytes, grown);
+        unsigned int crc = 0;
+        if (r.f_bytes > 0)
+            extract_bits_parallel(data, r.lsbs, r.bits - r.f_bytes*8, &dst[0], r.f_bytes,
+                                  threads, workers, key, 0, &crc);
+        r.stats.embed = clock.lap();
+        count_touched(r, r.f_bytes, r.bits, dst.capacity(), total);
+        if (r.checksummed && crc != r.checksum) return fail(r, CORRUPTED, CHECKSUM_MISMATCH);
+        return r;
+    }
+
+    Result Decoder::decrypt_stream(RGBView& view, DataSink sink) {
+        Stopwatch total, clock;
+        Result r = inspect(view);
+        r.stats.header = clock.lap();
+        if (r.status != SUCCESS) return r;
+        RGBView data = payload_view(view, r);
+        const Keystream* key = keystream_for(r);
+        if (r.status != SUCCESS) return r;
+
+        // compressed data goes through the inflater on its way to the sink
+        bool sink_failed = false;
+        DataSink raw = sink;
+        if (r.compressed) {
+            inflater.begin([&](const unsigned char* data, unsigned long n) {
+                if (raw(data, n)) return true;
+                sink_failed = true;
+                return false;
+            });
+            sink = [this](const unsigned char* data, unsigned long n) { return inflater.write(data, n); };
+        }
+
+        // extract the file data (right after the header bits) a block at a time
+        // and hand each block to the sink
+        unsigned long long pos = r.bits - r.f_bytes*8;
+        unsigned int crc = 0;
+        fit(block, std::min<unsigned long long>(r.f_bytes, OUT_BLOCK), grown);
+        r.stats.peak_buffer = block.capacity();
+        for (unsigned long long done=0; done<r.f_bytes; ) {
+            unsigned long long n = std::min<unsigned long long>(r.f_bytes - done, OUT_BLOCK);
+            unsigned int block_crc;
+            extract_bits_parallel(data, r.lsbs, pos + done*8, &block[0], n, threads, workers, key, done,
+                                  &block_crc);
+            crc = crc32c_combine(crc, block_crc, n);
+            r.stats.embed += clock.lap();
+            bool written = sink(&block[0], (unsigned long)n);
+            r.stats.write += clock.lap();
+            if (!written) {
+                if (r.checksummed && crc != r.checksum) return fail(r, CORRUPTED, CHECKSUM_MISMATCH);
+                if (r.compressed && !sink_failed) return fail(r, CORRUPTED, "Encryption corrupted.");
+                return fail(r, WRITE_FAILED, "Data file could not be written properly.");
+            }
+            done += n;
+        }
+        if (r.checksummed && crc != r.checksum) return fail(r, CORRUPTED, CHECKSUM_MISMATCH);
+        bool inflated = !r.compressed || (inflater.finish() && inflater.raw_bytes() == r.raw_bytes);
+        r.stats.write += clock.lap();
+        count_touched(r, r.compressed ? r.raw_bytes : r.f_bytes, r.bits, r.stats.peak_buffer, total);
+        if (!inflated) return fail(r, CORRUPTED, "Encryption corrupted.");
+        return r;
+    }
+
+    Result Decoder::extract_range(RGBView& view, unsigned long long offset, unsigned long long length,
+                                  std::vector<unsigned char>& dst) {
+        Stopwatch total, clock;
+        Result r = inspect(view);
+        r.stats.header = clock.lap();
+        if (r.status != SUCCESS) return r;
+        RGBView data = payload_view(view, r);
+        if (r.compressed)
+            return fail(r, BAD_ARGUMENT, "Compressed data can only be decrypted as a whole.");
+        if (offset > r.f_bytes || length > r.f_bytes - offset)
+            return fail(r, BAD_ARGUMENT, "Range is past the end of the data file.");
+        const Keystream* key = keystream_for(r);
+        if (r.status != SUCCESS) return r;
+
+        // byte offset of the data file is stream bit h_size + 8*offset, and the
+        // stream bit fixes the image byte; only the bytes of the range are read
+        fit(dst, length, grown);
+        if (length > 0)
+            extract_bits_parallel(data, r.lsbs, r.bits - (r.f_bytes - offset)*8, &dst[0], length,
+                                  threads, workers, key, offset);
+        r.stats.embed = clock.lap();
+        count_touched(r, length, length*8, dst.capacity(), total);
+        return r;
+    }
+
+    Result Decoder::verify(RGBView& view) {
+        Stopwatch total, clock;
+        Result r = inspect(view);
+        r.stats.header = clock.lap();
+        if (r.status != SUCCESS || !r.checksummed) return r;
+        RGBView data = payload_view(view, r);
+
+        // extract the data as stored (no key needed) a block at a time,
+        // checksumming it and throwing it away
+        unsigned long long pos = r.bits - r.f_bytes*8;
+        unsigned int crc = 0;
+        fit(block, std::min<unsigned long long>(r.f_bytes, OUT_BLOCK), grown);
+        for (unsigned long long done=0; done<r.f_bytes; ) {
+            unsigned long long n = std::min<unsigned long long>(r.f_bytes - done, OUT_BLOCK);
+            unsigned int block_crc;
+            extract_bits_parallel(data, r.lsbs, pos + done*8, &block[0], n, threads, workers, NULL, 0,
+                                  &block_crc);
+            crc = crc32c_combine(crc, block_crc, n);
+            done += n;
+        }
+        r.stats.embed = clock.lap();
+        count_touched(r, r.f_bytes, r.bits, block.capacity(), total);
+        if (crc != r.checksum) return fail(r, CORRUPTED, CHECKSUM_MISMATCH);
+        return r;
+    }
+
+    //
+    // one-off encrypt/decrypt
+    //
+
+    Result encrypt(RGBView& view, const unsigned char* data, unsigned long long size,
+                   std::string ext, int lsbs, int threads) {
+        return Encoder(lsbs, threads).encrypt(view, data, size, ext);
+    }
+
+    Result encrypt(unsigned char* rgb, int width, int height,
+                   const unsigned char* data, unsigned long long size,
+                   std::string ext, int lsbs, int threads) {
+        RGBView view(rgb, width, height, 1, 3, 3L*width);
+        return encrypt(view, data, size, ext, lsbs, threads);
+    }
+
+    Result encrypt_stream(RGBView& view, DataSource source, long long f_known,
+                          std::string ext, int lsbs, int threads) {
+        return Encoder(lsbs, threads).encrypt_stream(view, source, f_known, ext);
+    }
+
+    // inspect() for a view that may hold only the first rows of a width x
+    // height image (enough for the header); the payload is checked against
+    // the whole image
+    Result inspect_rows(RGBView& view, unsigned long width, unsigned long height) {
+        Result r;
+        r.bytes_available = (unsigned long long)width*height*view.channels();
+
+        // gather header info; images with alpha that were encrypted before
+        // alpha was used hold their header in R,G,B alone
+        HeaderV2 h;
+        if (!read_header(view, width, height, h)) {
+            if (view.channels() != 4) return fail(r, CORRUPTED, "Encryption corrupted.");
+            RGBView rgb = view.rgb();
+            return inspect_rows(rgb, width, height);
+        }
+        r.code = h.code;
+        r.lsbs = h.lsbs;
+        r.width = h.width;
+        r.height = h.height;
+        r.channels = view.channels();
+        r.sample_bits = view.sample_bits();
+        r.extension = h.extension;
+        r.f_bytes = h.f_bytes;
+        r.raw_bytes = h.raw_bytes;
+        r.compressed = (h.flags & FLAG_COMPRESSED) != 0;
+        r.keyed = (h.flags & FLAG_KEYED) != 0;
+        r.nonce = h.nonce;
+        r.checksummed = (h.flags & FLAG_CHECKSUM) != 0;
+        r.checksum = h.checksum;
+        r.shard = h.shard;
+        r.bits = h.h_size + h.f_bytes*8;
+
+        // validate
+        if (h.f_bytes > r.bytes_available || stream_bytes(r.bits, h.lsbs) > r.bytes_available)
+            return fail(r, CORRUPTED, "Encryption corrupted.");
+        return r;
+    }
+
+    Result inspect(RGBView& view) {
+        return inspect_rows(view, view.width(), view.height());
+    }
+
+    Result decrypt(RGBView& view, std::vector<unsigned char>& out, int threads) {
+        return Decoder(threads).decrypt(view, out);
+    }
+
+    Result decrypt(const unsigned char* rgb, int width, int height,
+                   std::vector<unsigned char>& out, int threads) {
+        // nothing is written through the view
+        RGBView view((unsigned char*)rgb, width, height, 1, 3, 3L*width);
+        return decrypt(view, out, threads);
+    }
+
+    Result decrypt_stream(RGBView& view, DataSink sink, int threads) {
+        return Decoder(threads).decrypt_stream(view, sink);
+    }
+
+    Result verify(RGBView& view, int threads) {
+        return Decoder(threads).verify(view);
+    }
+
+    Result extract_range(RGBView& view, unsigned long long offset, unsigned long long length,
+                         std::vector<unsigned char>& out, int threads) {
+        return Decoder(threads).extract_range(view, offset, length, out);
+    }
+
+    //
+    // file encrypt/decrypt
+    //
+
+    // view over a decoded image (R,G,B or R,G,B,A rows); 16-bit samples are
+    // big-endian, so their low byte is the second one
+    RGBView view_of(PngImage& image) {
+        int bps = image.depth / 8;
+        return RGBView(&image.pixels[0] + bps - 1, image.width, image.height, bps,
+                       (long)image.channels*bps, (long)image.channels*bps*image.width,
+                       image.channels, image.depth);
+    }
+
+    // decodes a PNG, or reads a whole 24-bit BMP, into memory without CImg
+    bool decode_image(std::string path, PngImage& image) {
+        if (read_png(path, image)) return true;
+        int rows;
+        image.channels = 3;
+        image.depth = 8;
+        return read_bmp_rows(path, ~0ULL, image.pixels, image.width, image.height, rows);
+    }
+
+    // an image opened for reading: mapped if it is a 24-bit BMP, decoded
+    // in-process if it is a PNG, decoded via CImg otherwise
+    struct OpenImage {
+        MappedBmp bmp;
+        PngImage png;
+        cimg_library::CImg<unsigned char> img;
+        std::unique_ptr<RGBView> view;
+        double load, unpack;    // seconds spent opening/decoding and viewing it
+
+        OpenImage() : load(0), unpack(0) {}
+
+        bool open(std::string path) {
+            Stopwatch clock;
+            if (bmp.open(path)) {
+                load = clock.lap();
+                view.reset(new RGBView(bmp.view()));
+                unpack = clock.lap();
+                return true;
+            }
+            if (read_png(path, png)) {
+                load = clock.lap();
+                view.reset(new RGBView(view_of(png)));
+                unpack = clock.lap();
+                return true;
+            }
+            try {
+                img.load(path.c_str());
+            } catch (cimg_library::CImgException&) {
+                return false;
+            }
+            load = clock.lap();
+            view.reset(new RGBView(img));
+            unpack = clock.lap();
+            return true;
+        }
+
+        // adds the time spent opening the image to a result
+        Result& timed(Result& r) const {
+            r.stats.load += load;
+            r.stats.unpack += unpack;
+            r.stats.total += load + unpack;
+            return r;
+        }
+    };
+
+    // threads each of n concurrent jobs may use for its own bands
+    int threads_per_job(int n, int threads) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        return threads > n ? threads / n : 1;
+    }
+
+    // encrypts data from a source into an image file and saves the result
+    // under a new name
+    Result encrypt_image(Encoder& encoder, std::string img_filename, std::string new_img_filename,
+                         DataSource source, long long f_known, std::string ext, const Shard& shard,
+                         const PngOptions& png_options) {
+        Result r;
+        Stopwatch total, clock;
+
+        // 24-bit BMPs saved as BMPs are copied and embedded in place through a
+        // mapping; PNGs (and BMPs saved as PNGs) are decoded in-process, and
+        // anything else via CImg. The image is saved again at the end, as a
+        // PNG if the new name ends in .png
+        bool png_out = png_name(new_img_filename);
+        MappedBmp bmp;
+        PngImage png;
+        cimg_library::CImg<unsigned char> img;
+        bool native = !png_out && bmp.open_copy(img_filename, new_img_filename);
+        bool decoded = !native && decode_image(img_filename, png);
+
+        // only a PNG keeps alpha and 16-bit samples, so anything else is
+        // embedded into 8-bit R,G,B to begin with
+        if (decoded && !png_out) to_rgb8(png);
+        if (!native && !decoded) {
+            try {
+                img.load(img_filename.c_str());
+            } catch (cimg_library::CImgException&) {
+                return fail(r, READ_FAILED, "Image file could not be opened.");
+            }
+        }
+        double load = clock.lap();
+
+        // a PNG is written from decoded R,G,B(,A) rows
+        if (png_out && !decoded) {
+            png.width = img.width();
+            png.height = img.height();
+            png.channels = 3;
+            png.depth = 8;
+            png.pixels.resize((size_t)png.width*png.height*3);
+            RGBView(img).gather(0, (unsigned long)png.pixels.size(), &png.pixels[0]);
+            decoded = true;
+        }
+        RGBView view = native ? bmp.view() : decoded ? view_of(png) : RGBView(img);
+        double unpack = clock.lap();
+
+        //
+        // encrypt
+        //
+
+        r = encoder.encrypt_stream(view, source, f_known, ext, shard);
+        clock.lap();
+        r.stats.load = load;
+        r.stats.unpack = unpack;
+        if (r.status != SUCCESS) {
+            r.stats.total = total.elapsed();
+            return r;
+        }
+
+        // save
+        bool saved = true;
+        if (native) {
+            saved = bmp.commit();
+        } else if (png_out) {
+            saved = write_png(new_img_filename, png, png_options);
+        } else {
+            if (decoded) {
+                std::vector<unsigned char> rgb((size_t)view.size());
+                view.gather(0, (unsigned long)rgb.size(), &rgb[0]);
+                img.assign(png.width, png.height, 1, 3);
+                RGBView(img).scatter(0, (unsigned long)rgb.size(), &rgb[0]);
+            }
+            try {
+                img.save(new_img_filename.c_str());
+            } catch (cimg_library::CImgException&) {
+                saved = false;
+            }
+        }
+        r.stats.save = clock.lap();
+        r.stats.total = total.elapsed();
+        if (!saved) return fail(r, WRITE_FAILED, "Image file could not be written to.");
+        return r;
+    }
+
+    Result encrypt_file(Encoder& encoder, std::string img_filename, std::string file_filename,
+                        std::string new_img_filename, const PngOptions& png) {
+        Result r;
+
+        // read binary ("-" reads standard input)
+        std::ifstream ifs;
+        std::istream* in = &std::cin;
+        if (file_filename != "-") {
+            ifs.open(file_filename.c_str(), std::ios::binary|std::ios::in);
+            in = &ifs;
+        }
+
+        // couldn't read :(
+        if (!*in) return fail(r, READ_FAILED, "Data file could not be opened.");
+
+        // size of the data file, if known before reading it
+        long long f_known = stream_size(*in);
+
+        return encrypt_image(encoder, img_filename, new_img_filename,
+                             [&](unsigned char* buf, unsigned long n) -> long {
+            in->read((char*)buf, (std::streamsize)n);
+            return in->bad() ? -1 : (long)in->gcount();
+        }, f_known, header_extension(file_filename), Shard(), png);
+    }
+
+    std::vector<Result> encrypt_shards(std::vector<std::string> img_filenames,
+                                       std::string file_filename,
+                                       std::vector<std::string> new_img_filenames,
+                                       int least_significant_bits, int threads, const PngOptions& png) {
+        int n = (int)img_filenames.size();
+        std::vector<Result> results(n);
+        if (new_img_filenames.size() != img_filenames.size()) {
+            for (int i=0; i<n; i++) fail(results[i], BAD_ARGUMENT, "Every image file needs an output name.");
+            return results;
+        }
+        if (n == 0) return results;
+
+        // the size has to be known up front to split the data file
+        long long f_bytes = file_filename == "-" ? -1 : file_size(file_filename);
+        if (f_bytes < 0) {
+            for (int i=0; i<n; i++) fail(results[i], READ_FAILED, "Data file could not be opened.");
+            return results;
+        }
+        std::string ext = header_extension(file_filename);
+
+        // what each image can hold next to its shard fields (image headers
+        // only); images not saved as PNGs lose their alpha and 16-bit samples
+        std::vector<long long> room(n);
+        long long total_room = 0;
+        for (int i=0; i<n; i++) {
+            int width, height, channels, sample_bits;
+            if (!image_format(img_filenames[i], width, height, channels, sample_bits)) {
+                fail(results[i], READ_FAILED, "Image file could not be opened.");
+                return results;
+            }
+            if (!png_name(new_img_filenames[i])) {
+                channels = 3;
+                sample_bits = 8;
+            }
+            room[i] = capacity_of(width, height, channels, sample_bits, least_significant_bits, ext);
+            if (room[i] < 0) {
+                for (int k=0; k<n; k++)
+                    fail(results[k], BAD_ARGUMENT, "Least significant bits must be between 1 and 7 (8 for 16-bit images).");
+                return results;
+            }
+            room[i] = room[i] > SHARD_BITS/8 ? room[i] - SHARD_BITS/8 : 0;
+            total_room += room[i];
+        }
+        if (f_bytes > total_room) {
+            for (int i=0; i<n; i++) {
+                fail(results[i], TOO_LARGE, "Data file is too large/image files are too small.");
+                results[i].f_bytes = f_bytes;
+                results[i].bytes_available = total_room;
+            }
+            return results;
+        }
+
+        // every image takes the same fraction of what it can hold, so the
+        // shards take about as long as each other
+        std::vector<unsigned long long> offset(n+1);
+        long long before = 0;
+        for (int i=0; i<n; i++) {
+            offset[i] = (unsigned long long)((long double)f_bytes * before / total_room);
+            before += room[i];
+        }
+        offset[n] = f_bytes;
+
+        // one ID for all the shards of this data file
+        std::random_device rd;
+        unsigned long long payload_id = ((unsigned long long)rd() << 32) ^ rd() ^
+            (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count();
+
+        int inner = threads_per_job(n, threads);
+        parallel_for(n, threads, [&](int i) {
+            Shard shard;
+            shard.index = i;
+            shard.count = n;
+            shard.payload_id = payload_id;
+            shard.offset = offset[i];
+
+            std::ifstream ifs(file_filename.c_str(), std::ios::binary|std::ios::in);
+            if (!ifs || !ifs.seekg((std::streamoff)offset[i])) {
+                fail(results[i], READ_FAILED, "Data file could not be opened.");
+                return;
+            }
+            unsigned long long left = offset[i+1] - offset[i];
+            Encoder encoder(least_significant_bits, inner);
+            results[i] = encrypt_image(encoder, img_filenames[i], new_img_filenames[i],
+                                       [&](unsigned char* buf, unsigned long k) -> long {
+                if (k > left) k = (unsigned long)left;
+                ifs.read((char*)buf, (std::streamsize)k);
+                if (ifs.bad()) return -1;
+                left -= ifs.gcount();
+                return (long)ifs.gcount();
+            }, offset[i+1] - offset[i], ext, shard, png);
+        });
+        return results;
+    }
+
+    Result decrypt_shards(std::vector<std::string> img_filenames, std::string prefix, int threads) {
+        Result total;
+        Stopwatch wall;
+        int n = (int)img_filenames.size();
+        if (n == 0) return fail(total, BAD_ARGUMENT, "No image files given.");
+
+        // open every image and read its header
+        std::vector<std::unique_ptr<OpenImage> > images(n);
+        std::vector<Result> shards(n);
+        parallel_for(n, threads, [&](int i) {
+            images[i].reset(new OpenImage);
+            if (!images[i]->open(img_filenames[i]))
+                fail(shards[i], READ_FAILED, "Image file could not be opened.");
+            else
+                shards[i] = inspect(*images[i]->view);
+        });
+
+        // every shard of one data file exactly once, whatever the order given
+        std::vector<int> order(n, -1);
+        for (int i=0; i<n; i++) {
+            if (shards[i].status != SUCCESS)
+                return fail(total, shards[i].status, img_filenames[i] + ": " + shards[i].message);
+            const Shard& s = shards[i].shard;
+            int count = s.count > 0 ? s.count : 1;
+            if (count != n || s.payload_id != shards[0].shard.payload_id ||
+                shards[i].extension != shards[0].extension || order[s.index] != -1) {
+                std::stringstream ss;
+                ss << img_filenames[i] << ": not one of " << n << " pieces of the same data file.";
+                return fail(total, CORRUPTED, ss.str());
+            }
+            order[s.index] = i;
+        }
+
+        // pieces follow each other without gaps
+        total = shards[order[0]];
+        total.f_bytes = 0;
+        total.raw_bytes = 0;
+        total.bits = 0;
+        total.bytes_available = 0;
+        for (int k=0; k<n; k++) {
+            const Result& r = shards[order[k]];
+            if (r.shard.offset != total.raw_bytes)
+                return fail(total, CORRUPTED, img_filenames[order[k]] + ": Encryption corrupted.");
+            total.f_bytes += r.f_bytes;
+            total.raw_bytes += r.raw_bytes;
+            total.bits += r.bits;
+            total.bytes_available += r.bytes_available;
+            total.compressed = total.compressed || r.compressed;
+        }
+        total.shard.index = 0;
+        total.shard.offset = 0;
+
+        // create the output file, then let every shard write its own range
+        std::string fname = prefix + (total.extension.empty() ? "" : "." + total.extension);
+        {
+            std::ofstream ofs(fname.c_str(), std::ios::binary|std::ios::out|std::ios::trunc);
+            if (!ofs) return fail(total, WRITE_FAILED, "Data file could not be written to.");
+        }
+        int inner = threads_per_job(n, threads);
+        std::vector<Result> written(n);
+        parallel_for(n, threads, [&](int i) {
+            std::fstream fs(fname.c_str(), std::ios::binary|std::ios::in|std::ios::out);
+            if (!fs || !fs.seekp((std::streamoff)shards[i].shard.offset)) {
+                fail(written[i], WRITE_FAILED, "Data file could not be written to.");
+                return;
+            }
+            Decoder decoder(inner);
+            written[i] = decoder.decrypt_stream(*images[i]->view, [&](const unsigned char* data, unsigned long k) {
+                fs.write((const char*)data, (std::streamsize)k);
+                return !fs.fail();
+            });
+            fs.flush();
+            if (written[i].status == SUCCESS && fs.fail())
+                fail(written[i], WRITE_FAILED, "Data file could not be written properly.");
+        });
+
+        // a partly written data file is not kept, as in decrypt()
+        for (int i=0; i<n; i++) {
+            if (written[i].status != SUCCESS) {
+                std::remove(fname.c_str());
+                return fail(total, written[i].status, img_filenames[i] + ": " + written[i].message);
+            }
+        }
+        total.stats.total = wall.elapsed();
+        return total;
+    }
+
+    Result extract_range(std::string img_filename, unsigned long long offset, unsigned long long length,
+                         std::vector<unsigned char>& out, const unsigned char* key, int threads) {
+        Result r;
+        OpenImage image;
+        if (!image.open(img_filename)) return fail(r, READ_FAILED, "Image file could not be opened.");
+        Decoder decoder(threads);
+        decoder.set_key(key);
+        r = decoder.extract_range(*image.view, offset, length, out);
+        return image.timed(r);
+    }
+
+    Result scan_file(std::string img_filename) {
+        Result r;
+        int width, height, rows;
+        if (!image_size(img_filename, width, height))
+            return fail(r, READ_FAILED, "Not a BMP or PNG image.");
+
+        // 24-bit BMPs: just the rows holding the longest possible header
+        std::vector<unsigned char> rgb;
+        if (read_bmp_rows(img_filename, stream_bytes(MAX_HEADER_BYTES*8ULL, 1), rgb, width, height, rows)) {
+            RGBView view(&rgb[0], width, rows, 1, 3, 3L*width);
+            return inspect_rows(view, width, height);
+        }
+
+        // anything else has to be decoded
+        OpenImage image;
+        if (!image.open(img_filename)) return fail(r, READ_FAILED, "Image file could not be opened.");
+        return inspect(*image.view);
+    }
+
+    Result verify_file(std::string img_filename, int threads) {
+        Result r;
+        OpenImage image;
+        if (!image.open(img_filename)) return fail(r, READ_FAILED, "Image file could not be opened.");
+        r = verify(*image.view, threads);
+        return image.timed(r);
+    }
+
+    // a string as a JSON string literal
+    std::string json_string(const std::string& str) {
+        std::stringstream ss;
+        ss << '"';
+        for (unsigned long i=0; i<str.size(); i++) {
+            unsigned char c = (unsigned char)str[i];
+            if (c == '"' || c == '\\') ss << '\\' << c;
+            else if (c < 0x20) ss << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+            else ss << c;
+        }
+        ss << '"';
+        return ss.str();
+    }
+
+    std::string to_json(const Result& r) {
+        static const char* names[] = {"SUCCESS", "BAD_ARGUMENT", "TOO_LARGE", "CORRUPTED",
+                                      "READ_FAILED", "WRITE_FAILED"};
+        const Stats& s = r.stats;
+        std::stringstream ss;
+        ss.precision(9);
+        ss << "{\"status\":\"" << names[r.status] << "\",\"message\":" << json_string(r.message)
+           << ",\"code\":" << r.code << ",\"lsbs\":" << r.lsbs
+           << ",\"width\":" << r.width << ",\"height\":" << r.height
+           << ",\"channels\":" << r.channels << ",\"sample_bits\":" << r.sample_bits
+           << ",\"extension\":" << json_string(r.extension)
+           << ",\"f_bytes\":" << r.f_bytes << ",\"raw_bytes\":" << r.raw_bytes
+           << ",\"bits\":" << r.bits << ",\"bytes_available\":" << r.bytes_available
+           << ",\"compressed\":" << (r.compressed ? "true" : "false")
+           << ",\"keyed\":" << (r.keyed ? "true" : "false")
+           << ",\"checksummed\":" << (r.checksummed ? "true" : "false")
+           << ",\"stats\":{\"read\":" << s.read << ",\"load\":" << s.load << ",\"unpack\":" << s.unpack
+           << ",\"header\":" << s.header << ",\"embed\":" << s.embed << ",\"save\":" << s.save
+           << ",\"write\":" << s.write << ",\"total\":" << s.total
+           << ",\"payload_bytes\":" << s.payload_bytes << ",\"image_bytes\":" << s.image_bytes
+           << ",\"pixels\":" << s.pixels << ",\"peak_buffer\":" << s.peak_buffer << "}}";
+        return ss.str();
+    }
+
+    Result encrypt(std::string img_filename, std::string file_filename,
+                   int least_significant_bits, int threads, int level, std::string key_filename,
+                   std::string new_img_filename, const PngOptions& png) {
+        Encoder encoder(least_significant_bits, threads, level);
+        unsigned char key[KEY_BYTES];
+        if (!key_filename.empty()) {
+            if (!load_key(key_filename, key)) {
+                Result r;
+                std::cout << "ERROR: Key file must hold exactly " << KEY_BYTES << " bytes." << std::endl;
+                return fail(r, BAD_ARGUMENT, "Key file does not hold a key.");
+            }
+            encoder.set_key(key);
+        }
+        Result r = encrypt_file(encoder, img_filename, file_filename, new_img_filename, png);
+
+        // how the encryption bits compare to what the image can hold
+        if (r.status == SUCCESS || r.status == TOO_LARGE)
+            report_fit(r.bits, r.bytes_available, least_significant_bits, r.channels);
+        if (r.status == SUCCESS && r.compressed)
+            report_compression(r);
+        if (r.status != SUCCESS) {
+            if (r.status != TOO_LARGE) std::cout << "ERROR: " << r.message << std::endl;
+            return r;
+        }
+
+        // number of pixels touched by the header and file data
+        long long changed = (stream_bytes(r.bits, least_significant_bits)+r.channels-1)/r.channels;
+        std::cout<<changed<<"/"<<(long long)r.width*r.height<<" pixels were encrypted."<<std::endl;
+        std::cout << "Encryption successful; saved as \"" << new_img_filename << "\"." << std::endl;
+        return r;
+    }
+
+    Result decrypt(std::string fp, int threads, std::string key_filename) {
+        Result fault;
+
+        //
+        //  Read image file (mapped if it is a 24-bit BMP, via CImg otherwise)
+        //
+
+        OpenImage image;
+        if (!image.open(fp)) {
+            std::cout << "ERROR: Image file could not be opened." << std::endl;
+            return fail(fault, READ_FAILED, "Image file could not be opened.");
+        }
+
+        // view image data as interleaved R,G,B bytes
+        RGBView& img_data = *image.view;
+
+        //
+        //  Gather header info
+        //
+
+        Result h = inspect(img_data);
+        if (h.status != SUCCESS) {
+            std::cout << "ERROR: " << h.message << std::endl;
+            return image.timed(h);
+        }
+        if (h.shard.count > 1) {
+            std::cout << "ERROR: Image holds piece "<<h.shard.index+1<<" of "<<h.shard.count
+                      <<" of a data file; decrypt all of them together." << std::endl;
+            return fail(image.timed(h), BAD_ARGUMENT, "Image holds one piece of a split data file.");
+        }
+
+        // get extension for filename
+        std::string ext = h.extension.empty() ? "" : "." + h.extension;
+
+        // report
+        std::cout<<"---------------------------\n";
+        std::cout<<"Decrypted with header info:\n";
+        std::cout<<"\tCode:\t\t"<<h.code<<"\n";
+        std::cout<<"\tLeast bits:\t"<<h.lsbs<<" bits\n";
+        std::cout<<"\tSource Width:\t"<<h.width<<" px\n";
+        std::cout<<"\tSource Height:\t"<<h.height<<" px\n";
+        std::cout<<"\tChannels:\t"<<(h.channels == 4 ? "R,G,B,A" : "R,G,B")<<"\n";
+        std::cout<<"\tSample Depth:\t"<<h.sample_bits<<" bits\n";
+        std::cout<<"\tExtension:\t"<<ext<<"\n";
+        std::cout<<"\tData Size:\t"<<h.f_bytes*8<<" bits\n";
+        if (h.compressed)
+            std::cout<<"\tUncompressed:\t"<<h.raw_bytes*8<<" bits\n";
+        if (h.keyed)
+            std::cout<<"\tNonce:\t\t"<<std::hex<<h.nonce<<std::dec<<"\n";
+        if (h.checksummed)
+            std::cout<<"\tCRC32C:\t\t"<<std::hex<<h.checksum<<std::dec<<"\n";
+        std::cout<<"\tSeparator:\tx\n";
+        std::cout<<"---------------------------\n";
+
+        //
+        //  Write decrypted file
+        //
+
+        // keyed data needs the key before anything is written
+        Decoder decoder(threads);
+        unsigned char key[KEY_BYTES];
+        if (h.keyed) {
+            if (key_filename.empty() || !load_key(key_filename, key)) {
+                std::cout << "ERROR: Data file is keyed; give a key file of " << KEY_BYTES << " bytes." << std::endl;
+                return fail(image.timed(h), BAD_ARGUMENT, "Data file is keyed; a key is needed to decrypt it.");
+            }
+            decoder.set_key(key);
+        }
+
+        // make the filename
+        std::string fname = "decrypted" + ext;
+
+        // open binary mode
+        std::ofstream ofs(fname.c_str(), std::ios::binary | std::ios::out);
+
+        // abort if failed to open
+        if (!ofs) {
+            std::cout << "ERROR: Data file could not be written to." << std::endl;
+            return fail(image.timed(h), WRITE_FAILED, "Data file could not be written to.");
+        }
+
+        // extract the file data a block at a time into the output file stream
+        Result r = decoder.decrypt_stream(img_data, [&](const unsigned char* data, unsigned long n) {
+            ofs.write((const char*)data, (std::streamsize)n);
+            return !ofs.fail();
+        });
+
+        // close the filestream
+        Stopwatch clock;
+        ofs.flush();
+        ofs.close();
+        r.stats.write += clock.elapsed();
+        r.stats.total += clock.elapsed();
+        image.timed(r);
+
+        // corrupted data is not kept
+        if (r.status == CORRUPTED) {
+            std::remove(fname.c_str());
+            std::cout << "ERROR: " << r.message << " Nothing was saved." << std::endl;
+            return r;
+        }
+
+        // exception if something went wrong
+        if (r.status != SUCCESS || ofs.bad()) {
+            std::cout << "ERROR: Data file could not be written properly." << std::endl;
+            return r.status != SUCCESS ? r : fail(r, WRITE_FAILED, "Data file could not be written properly.");
+        } else {
+            std::cout << "Decryption successful; saved as \"decrypted"<<ext<<"\"." << std::endl;
+        }
+        return r;
+    }
+
+    //
+    // self-checks
+    //
+
+    bool check_headers(unsigned int seed) {
+        std::mt19937_64 rng(seed);
+
+        // version 2: every field at its full width, read back from a carrier
+        // just large enough for the header
+        for (int round=0; round<64; round++) {
+            int lsbs = 1 + (int)(rng() % 7);
+            std::string ext;
+            for (int i=(int)(rng() % 20); i>0; i--) ext += (char)('a' + rng() % 26);
+            Shard shard;
+            if (rng() % 2) {
+                shard.count = 1 + (int)(rng() % 65535);
+                shard.index = (int)(rng() % shard.count);
+                shard.payload_id = rng();
+                shard.offset = rng();
+            }
+            Keystream key;
+            key.set_nonce(rng());
+            bool keyed = rng() % 2 != 0, compressed = rng() % 2 != 0;
+            // sizes past 2^32 bits, dimensions past 2^31
+            unsigned long long f_bytes = (1ULL << 29) + rng() % (1ULL << 40);
+            HeaderV2 h = create_header_v2(0xffffffffUL - rng() % 65536, 0x80000000UL + rng() % 65536, ext,
+                                          lsbs, f_bytes, shard, compressed, keyed ? &key : NULL, 0);
+            if (compressed) h.raw_bytes = f_bytes * 3;
+            h.checksum = (unsigned int)rng();
+
+            int w = 16, rows = (int)((stream_bytes(h.h_size, lsbs) + 3*w - 1) / (3*w));
+            std::vector<unsigned char> rgb(3*w*rows);
+            for (unsigned long i=0; i<rgb.size(); i++) rgb[i] = (unsigned char)rng();
+            RGBView view(&rgb[0], w, rows, 1, 3, 3L*w);
+            BitPacker p = pack_header(h);
+            embed_bits(view, lsbs, 0, p.bytes, 0, p.bits);
+
+            HeaderV2 out;
+            if (!read_header(view, h.width, h.height, out) || out.code != CODE_V2 || out.lsbs != lsbs ||
+                out.flags != h.flags || out.f_bytes != h.f_bytes || out.extension != ext ||
+                out.shard.index != shard.index || out.shard.count != shard.count ||
+                out.shard.payload_id != shard.payload_id || out.shard.offset != shard.offset ||
+                out.raw_bytes != h.raw_bytes || out.nonce != h.nonce || out.checksum != h.checksum ||
+                out.h_size != h.h_size)
+                return false;
+        }
+
+        // version 1: code "11" and separator-delimited fields, laid out as the
+        // original encoder wrote them, with the data right after
+        for (int round=0; round<16; round++) {
+            int lsbs = 1 + (int)(rng() % 7);
+            int w = 20 + (int)(rng() % 40), h = 20 + (int)(rng() % 40);
+            std::string ext = round % 4 == 0 ? "" : "txt";
+            std::vector<unsigned char> data(rng() % 300), rgb(3*w*h);
+            for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)rng();
+            for (unsigned long i=0; i<rgb.size(); i++) rgb[i] = (unsigned char)rng();
+
+            BitPacker p;
+            p.put(CODE_V1, 2);
+            p.put(lsbs, 3);
+            p.put('x', 8);
+            p.put(w, 11);
+            p.put('x', 8);
+            p.put(h, 11);
+            p.put('x', 8);
+            for (int i=0; i<(int)ext.size(); i++) p.put((unsigned char)ext[i], 8);
+            p.put('\n', 8);
+            p.put(data.size()*8, 32);
+            p.put('x', 8);
+            RGBView view(&rgb[0], w, h, 1, 3, 3L*w);
+            if (stream_bytes(p.bits + data.size()*8, lsbs) > view.size()) continue;
+            embed_bits(view, lsbs, 0, p.bytes, 0, p.bits);
+            if (!data.empty()) embed_bits(view, lsbs, p.bits, &data[0], 0, data.size()*8);
+
+            std::vector<unsigned char> out;
+            Result r = decrypt(view, out, 1);
+            if (r.status != SUCCESS || r.code != CODE_V1 || r.lsbs != lsbs || r.checksummed ||
+                r.extension != ext || out != data)
+                return false;
+        }
+        return true;
+    }
+
+    bool check_bands(unsigned int seed) {
+        std::mt19937_64 rng(seed);
+        Workers workers;
+        const int THREADS = 5;
+
+        // a carrier of a little over three bands, with an odd width, so bands
+        // are uneven and start and end inside rows
+        int w = 1021 + 2*(int)(rng() % 32);
+        int h = (int)((3*MIN_BAND + 1 + rng() % MIN_BAND) / (3*w));
+        std::vector<unsigned char> carrier(3*w*h);
+        for (unsigned long i=0; i<carrier.size(); i++) carrier[i] = (unsigned char)rng();
+        unsigned char k[KEY_BYTES];
+        for (int i=0; i<KEY_BYTES; i++) k[i] = (unsigned char)rng();
+        Keystream key;
+        key.set_key(k);
+        key.set_nonce(rng());
+
+        for (int lsbs=1; lsbs<=7; lsbs++) {
+            // the stream starts anywhere (after a header) and stops short of the end
+            unsigned long long pos = rng() % 200;
+            unsigned long long nbits = FIXED_BITS + (carrier.size() - FIXED_BYTES)*lsbs - pos - 1 - rng() % 1000;
+            EmbedBands bands(lsbs, pos, nbits, THREADS);
+            if (bands.whole % bands.count == 0) {
+                nbits -= lsbs;
+                bands = EmbedBands(lsbs, pos, nbits, THREADS);
+            }
+            if (bands.count < 2 || bands.whole % bands.count == 0) return false;
+            std::vector<unsigned char> src((size_t)((nbits + 7) / 8));
+            for (unsigned long i=0; i<src.size(); i++) src[i] = (unsigned char)rng();
+            const Keystream* keyed = lsbs % 2 ? &key : NULL;
+
+            // one thread and several give the same image and checksum ...
+            std::vector<unsigned char> one(carrier), many(carrier);
+            RGBView one_view(&one[0], w, h, 1, 3, 3L*w), many_view(&many[0], w, h, 1, 3, 3L*w);
+            unsigned int one_crc, many_crc;
+            embed_bits_parallel(one_view, lsbs, pos, &src[0], nbits, 1, workers, keyed, &one_crc);
+            embed_bits_parallel(many_view, lsbs, pos, &src[0], nbits, THREADS, workers, keyed, &many_crc);
+            if (one != many || one_crc != many_crc) return false;
+
+            // ... and the same data back out, which is what went in
+            unsigned long long nbytes = nbits / 8;
+            std::vector<unsigned char> one_out((size_t)nbytes), many_out((size_t)nbytes);
+            extract_bits_parallel(one_view, lsbs, pos, &one_out[0], nbytes, 1, workers, keyed, 0, &one_crc);
+            extract_bits_parallel(one_view, lsbs, pos, &many_out[0], nbytes, THREADS, workers, keyed, 0, &many_crc);
+            if (one_out != many_out || one_crc != many_crc || !std::equal(one_out.begin(), one_out.end(), src.begin()))
+                return false;
+        }
+        return true;
+    }
+} // end of namespace
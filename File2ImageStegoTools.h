@@ -1,77 +1,440 @@
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Author:         Ibrahim Sardar
-//  Class:          CSCI 557
-//  Filename:       File2ImageStegoTools.h
-//  Date:           04/20/2018
-//  Description:    Header for Stenography: File-to-Image Tools namespace.
-//
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Honor Pledge:
-//
-//  I pledge that I have neither given nor received any help on this project.
-//
-//  ibsardar
-//
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
-//
-////////////////////////////////////////////////////////////////////////////////
-
-#ifndef _FILE2IMAGESTEGOTOOLS_H_
-#define _FILE2IMAGESTEGOTOOLS_H_
-
-#include <string>
-#include <vector>
-#include <bitset>
-#include "CImg.h"
-
-namespace f2i_stego_tools {
-
-    // contains header info of an encrypted image
-    struct Header;
-
-    // string 2 int
-    int s2i(std::string);
-
-    // int 2 string
-    std::string i2s (int);
-
-    // char (byte) 2 unsigned int
-    unsigned int b2ui(unsigned char);
-
-    // unsigned int 2 char (byte)
-    unsigned char ui2b(unsigned int);
-
-    // bitset 2 unsigned int
-    unsigned int bs2ui(std::bitset<8>&);
-
-    // string 2 bitset
-    std::bitset<8> s2bs(std::string);
-
-    // unsigned int 2 bitset
-    std::bitset<8> ui2bs(unsigned int i);
-
-    // char (byte) 2 bitset
-    std::bitset<8> b2bs(unsigned char);
-
-    // returns a list bytes from an image
-    std::vector<std::bitset<8> > get_data_from_img(cimg_library::CImg<unsigned char>&);
-
-    // returns a list of bytes from a filename's extension
-    std::vector<std::bitset<8> > get_extension_data(std::string);
-
-    // constructs and returns a header structure from the input data
-    Header create_header_data(cimg_library::CImg<unsigned char>&, std::vector<std::bitset<8> >&,
-                              int, int, std::vector<std::bitset<8> >&);
-
-    // encrypts an arbitrary file into a bitmap image
-    void encrypt(std::string, std::string, int lsbs=1);
-
-    // decrypts an arbitrary file from an encrypted bitmap image
-    void decrypt(std::string);
-}
-
-#endif   // !defined _FILE2IMAGESTEGOTOOLS_H_
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       File2ImageStegoTools.h
+//  Date:           04/20/2018
+//  Description:    Header for Stenography: File-to-Image Tools namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _FILE2IMAGESTEGOTOOLS_H_
+#define _FILE2IMAGESTEGOTOOLS_H_
+
+#include <string>
+#include <vector>
+#include <bitset>
+#include <functional>
+#include <random>
+#include "CImg.h"
+#include "StegoWorkers.h"
+#include "StegoCompress.h"
+#include "StegoCipher.h"
+#include "StegoPng.h"
+
+namespace f2i_stego_tools {
+
+    // contains header info of an encrypted image
+    struct Header;
+
+    // interleaved R,G,B (or R,G,B,A) view over the pixel data of an image,
+    // whatever its memory layout (CImg's planes, BMP rows, 16-bit PNG rows,
+    // ...); reads and writes the image buffer in place instead of copying it.
+    // Every sample shows up as one byte: the sample itself in 8-bit images,
+    // its least significant byte in 16-bit ones
+    class RGBView {
+    public:
+        // the R,G,B planes of an 8-bit (unsigned char) or 16-bit (unsigned
+        // short) CImg, and its alpha plane too if asked for and it has one
+        template<class T>
+        explicit RGBView(cimg_library::CImg<T>&, bool alpha=false);
+
+        // the byte seen of sample (x, y, c) of a w x h image lives at
+        // origin + c*c_step + x*x_step + y*y_step (steps in bytes, may be negative)
+        RGBView(unsigned char* origin, int w, int h, long c_step, long x_step, long y_step,
+                int channels=3, int sample_bits=8);
+
+        // number of samples (one byte each) in the image
+        unsigned long long size() const { return n; }
+
+        // dimensions of the image in pixels
+        unsigned long width() const { return (unsigned long)w; }
+        unsigned long height() const { return w ? (unsigned long)(n / ch / w) : 0; }
+
+        // samples per pixel (3, or 4 with alpha) and bits per sample (8 or 16)
+        int channels() const { return ch; }
+        int sample_bits() const { return bits; }
+
+        // the same image without its alpha channel
+        RGBView rgb() const;
+
+        // i-th byte in R,G,B(,A),R,G,B(,A),... order (row by row)
+        unsigned char operator[](unsigned long long i) const { return *at(i); }
+
+        // bit b of the i-th byte
+        bool bit(unsigned long long i, int b) const { return ((*this)[i] >> b) & 1; }
+
+        // copies bytes [first, first+count) into out
+        void gather(unsigned long long first, unsigned long count, unsigned char* out) const;
+
+        // copies count bytes from in back into [first, first+count)
+        void scatter(unsigned long long first, unsigned long count, const unsigned char* in);
+
+    private:
+        unsigned char* at(unsigned long long i) const {
+            unsigned long long p = i / ch;
+            return origin + (long long)(i % ch)*c_step + (long long)(p % w)*x_step
+                          + (long long)(p / w)*y_step;
+        }
+
+        // gather()/scatter() for C channels per pixel
+        template<int C> void gather_px(unsigned long long first, unsigned long count, unsigned char* out) const;
+        template<int C> void scatter_px(unsigned long long first, unsigned long count, const unsigned char* in);
+
+        unsigned char* origin;
+        unsigned long long w;
+        long c_step, x_step, y_step;
+        unsigned long long n;
+        int ch, bits;
+    };
+
+    // how an in-memory encrypt/decrypt ended
+    enum Status {
+        SUCCESS,
+        BAD_ARGUMENT,   // lsbs out of range, extension too long
+        TOO_LARGE,      // data file does not fit into the image
+        CORRUPTED,      // no valid header in the image, or data not matching its checksum
+        READ_FAILED,    // data source reported an error
+        WRITE_FAILED    // data sink reported an error
+    };
+
+    // where a piece of a data file split across several images belongs
+    struct Shard {
+        Shard() : index(0), count(0), payload_id(0), offset(0) {}
+
+        int index;                          // 0 .. count-1
+        int count;                          // number of images (0 = not split)
+        unsigned long long payload_id;      // the same in every piece of one data file
+        unsigned long long offset;          // first data file byte in this piece
+    };
+
+    // wall time (seconds) of each phase of an encrypt/decrypt and what it
+    // touched; phases that did not happen stay 0. Reading the data file
+    // overlaps embedding (the next block is read while one is embedded), so
+    // the phases can add up to more than total
+    struct Stats {
+        Stats();
+
+        double read;                        // pulling the data file from its source (and deflating it)
+        double load;                        // opening/mapping or decoding the image file
+        double unpack;                      // setting up the R,G,B view of the image
+        double header;                      // building and embedding, or reading, the header
+        double embed;                       // embedding or extracting the file data
+        double save;                        // writing the image file
+        double write;                       // handing the data to its sink (and inflating it)
+        double total;                       // the whole call
+        unsigned long long payload_bytes;   // file data bytes embedded or extracted
+        unsigned long long image_bytes;     // sample bytes holding header and file data
+        unsigned long long pixels;          // pixels holding header and file data
+        unsigned long long peak_buffer;     // bytes in the largest block buffer used
+    };
+
+    // outcome of an in-memory encrypt/decrypt, in place of printed messages
+    struct Result {
+        Result();
+
+        Status status;
+        std::string message;                // what went wrong (empty on success)
+        int code;                           // header version code
+        int lsbs;                           // least significant bits
+        unsigned long width;                // width of image
+        unsigned long height;               // height of image
+        int channels;                       // samples per pixel the data runs through (3, or 4 with alpha)
+        int sample_bits;                    // bits per sample of the image (8 or 16)
+        std::string extension;              // extension of data file
+        unsigned long long f_bytes;         // bytes of file data in the image
+        unsigned long long raw_bytes;       // bytes of the data file (before compression)
+        bool compressed;                    // file data was deflated before embedding
+        bool keyed;                         // file data was XORed with a keystream
+        unsigned long long nonce;           // the keystream's nonce, if keyed
+        bool checksummed;                   // the header holds a checksum of the file data
+        unsigned int checksum;              // CRC32C of the file data as stored in the image
+        Shard shard;                        // piece of a split data file, if it is one
+        unsigned long long bits;            // header and file data bits (needed, if too large)
+        unsigned long long bytes_available; // sample bytes in the image (R,G,B, and A if used)
+        Stats stats;                        // where the time went
+    };
+
+    // fills up to n bytes of buf with the next data; returns how many (0 at
+    // the end of the data, negative on a read error)
+    typedef std::function<long(unsigned char* buf, unsigned long n)> DataSource;
+
+    // takes the next n bytes of decrypted data; returns false on a write error
+    typedef std::function<bool(const unsigned char* data, unsigned long n)> DataSink;
+
+    // string 2 int
+    int s2i(std::string);
+
+    // int 2 string
+    std::string i2s (int);
+
+    // char (byte) 2 unsigned int
+    unsigned int b2ui(unsigned char);
+
+    // unsigned int 2 char (byte)
+    unsigned char ui2b(unsigned int);
+
+    // bitset 2 unsigned int
+    unsigned int bs2ui(std::bitset<8>&);
+
+    // string 2 bitset
+    std::bitset<8> s2bs(std::string);
+
+    // unsigned int 2 bitset
+    std::bitset<8> ui2bs(unsigned int i);
+
+    // char (byte) 2 bitset
+    std::bitset<8> b2bs(unsigned char);
+
+    // returns a list bytes from an image (copies; prefer RGBView)
+    std::vector<std::bitset<8> > get_data_from_img(cimg_library::CImg<unsigned char>&);
+
+    // returns a list of bytes from a filename's extension
+    std::vector<std::bitset<8> > get_extension_data(std::string);
+
+    // constructs and returns a header structure from the input data
+    Header create_header_data(cimg_library::CImg<unsigned char>&, std::vector<std::bitset<8> >&,
+                              int, int, std::vector<std::bitset<8> >&);
+
+    // constructs and returns a header structure for a data file of the given byte size
+    Header create_header_data(cimg_library::CImg<unsigned char>&, std::vector<std::bitset<8> >&,
+                              int, int, unsigned long);
+
+    // width and height of a BMP or PNG image, read from its file header only
+    bool image_size(std::string, int& width, int& height);
+
+    // image_size(), and the samples per pixel (4 for PNGs with an alpha
+    // channel or tRNS transparency) and bits per sample (16 for 16-bit PNGs)
+    // a carrier offers, as read_png() will decode it
+    bool image_format(std::string, int& width, int& height, int& channels, int& sample_bits);
+
+    // size of a file in bytes (-1 if it cannot be found)
+    long long file_size(std::string);
+
+    // number of data file bytes an image can hold at this many least
+    // significant bits, given the data file's extension (it goes into the
+    // header) and whether the result is saved as a PNG: only then are alpha
+    // and 16-bit samples (and lsbs up to 8) kept, otherwise the image counts
+    // as 8-bit R,G,B. Reads only the image's file header, -1 if it cannot be
+    // read or lsbs is out of range
+    long long capacity(std::string, int lsbs=1, std::string ext="", bool png=false);
+
+    // whether a data file of this many bytes fits into an image
+    bool fits(std::string, unsigned long long f_bytes, int lsbs=1, std::string ext="", bool png=false);
+
+    // whether a data file (sized without reading it) fits into an image
+    bool fits(std::string, std::string, int lsbs=1, bool png=false);
+
+    // encrypts into images in memory, keeping its block buffers and worker
+    // threads between calls; once it has handled one job of a given size,
+    // further jobs of that size make no heap allocations
+    class Encoder {
+    public:
+        // level 1..9 deflates the data before embedding it (0 = store as is)
+        explicit Encoder(int lsbs=1, int threads=0, int level=0);
+
+        // see encrypt() and encrypt_stream() below; a shard with a count is
+        // recorded in the header
+        Result encrypt(RGBView&, const unsigned char* data, unsigned long long size,
+                       std::string ext="", const Shard& shard=Shard());
+        Result encrypt_stream(RGBView&, DataSource, long long f_bytes, std::string ext="",
+                              const Shard& shard=Shard());
+
+        // least significant bits used from the next call on
+        void set_lsbs(int l) { lsbs = l; }
+
+        // compression level used from the next call on (0 = none)
+        void set_compression(int l) { level = l; }
+
+        // KEY_BYTES bytes of key from the next call on (NULL = none); the data
+        // is XORed with a ChaCha20 keystream as it is embedded, under a fresh
+        // nonce each call that goes into the header
+        void set_key(const unsigned char* key);
+
+        // times a pooled buffer has grown or a worker thread was started so
+        // far, each one heap allocation or more (the allocations test counts
+        // the real ones through operator new)
+        unsigned long long allocations() const;
+
+    private:
+        // keystream under a new nonce, or NULL without a key
+        const Keystream* next_keystream();
+
+        int lsbs;
+        int threads;
+        int level;
+        bool keyed;
+        Keystream keystream;
+        std::mt19937_64 nonces;
+        Workers workers;
+        Deflater deflater;
+        std::vector<unsigned char> block, next;   // data read ahead of embedding
+        unsigned long long grown;
+    };
+
+    // decrypts images in memory, keeping its output buffer and worker
+    // threads between calls like Encoder
+    class Decoder {
+    public:
+        explicit Decoder(int threads=0);
+
+        // decrypts into the decoder's own buffer, see data()
+        Result decrypt(RGBView&);
+
+        // decrypts into out (resized; only grows when a larger file comes along)
+        Result decrypt(RGBView&, std::vector<unsigned char>& out);
+
+        // see decrypt_stream() below
+        Result decrypt_stream(RGBView&, DataSink);
+
+        // see verify() below
+        Result verify(RGBView&);
+
+        // see extract_range() below
+        Result extract_range(RGBView&, unsigned long long offset, unsigned long long length,
+                             std::vector<unsigned char>& out);
+
+        // key for keyed images from the next call on (NULL = none), see Encoder
+        void set_key(const unsigned char* key);
+
+        // data of the last decrypt(RGBView&)
+        const std::vector<unsigned char>& data() const { return out; }
+
+        // times a pooled buffer has grown or a worker thread was started so
+        // far, each one heap allocation or more (the allocations test counts
+        // the real ones through operator new)
+        unsigned long long allocations() const;
+
+    private:
+        // keystream for a keyed image (NULL if it is not keyed; fails r without a key)
+        const Keystream* keystream_for(Result& r);
+
+        int threads;
+        bool keyed;
+        Keystream keystream;
+        Workers workers;
+        Inflater inflater;
+        std::vector<unsigned char> out;     // decrypted data
+        std::vector<unsigned char> block;   // decrypt_stream() block
+        unsigned long long grown;
+    };
+
+    // encrypts size bytes of data into an image in memory; ext is stored as
+    // the data's extension (no file or console I/O)
+    Result encrypt(RGBView&, const unsigned char* data, unsigned long long size,
+                   std::string ext="", int lsbs=1, int threads=0);
+
+    // same, for a width x height image stored as interleaved R,G,B rows
+    Result encrypt(unsigned char* rgb, int width, int height,
+                   const unsigned char* data, unsigned long long size,
+                   std::string ext="", int lsbs=1, int threads=0);
+
+    // encrypts data pulled from a source a block at a time; f_bytes is its
+    // size if known up front (-1 otherwise, the header is filled in at the end)
+    Result encrypt_stream(RGBView&, DataSource, long long f_bytes,
+                          std::string ext="", int lsbs=1, int threads=0);
+
+    // reads and validates the header of an encrypted image without extracting
+    Result inspect(RGBView&);
+
+    // decrypts the data hidden in an image into out
+    Result decrypt(RGBView&, std::vector<unsigned char>& out, int threads=0);
+
+    // same, for a width x height image stored as interleaved R,G,B rows
+    Result decrypt(const unsigned char* rgb, int width, int height,
+                   std::vector<unsigned char>& out, int threads=0);
+
+    // decrypts the data hidden in an image into a sink a block at a time
+    Result decrypt_stream(RGBView&, DataSink, int threads=0);
+
+    // decrypts only bytes [offset, offset+length) of the data hidden in an
+    // image into out, reading just the image bytes that hold them, so the
+    // time taken follows the length and not the size of the data file (the
+    // checksum covers the whole file and is not checked; compressed data
+    // cannot be read this way, and offsets of a shard are within the shard)
+    Result extract_range(RGBView&, unsigned long long offset, unsigned long long length,
+                         std::vector<unsigned char>& out, int threads=0);
+
+    // same, for an image file; 24-bit BMPs are mapped, so only the pages
+    // holding the range are read from disk. key is needed for keyed data
+    Result extract_range(std::string img_filename, unsigned long long offset,
+                         unsigned long long length, std::vector<unsigned char>& out,
+                         const unsigned char* key=NULL, int threads=0);
+
+    // checks the data hidden in an image against the checksum in its header
+    // without decrypting or keeping it (no key needed); a header without a
+    // checksum (older images) succeeds with checksummed unset
+    Result verify(RGBView&, int threads=0);
+
+    // encrypts a data file ("-" = standard input) into an image file and saves
+    // the result under a new name, without console output; a name ending in
+    // .png is written as a PNG with these options
+    Result encrypt_file(Encoder&, std::string img_filename, std::string file_filename,
+                        std::string new_img_filename, const PngOptions& png=PngOptions());
+
+    // splits a data file across several images, in proportion to what each
+    // can hold, and saves them under the new names; every header records the
+    // piece's index, the number of pieces and an ID shared by all of them.
+    // The pieces are embedded on this many threads (0 = one per hardware
+    // thread); returns one result per image
+    std::vector<Result> encrypt_shards(std::vector<std::string> img_filenames,
+                                       std::string file_filename,
+                                       std::vector<std::string> new_img_filenames,
+                                       int lsbs=1, int threads=0, const PngOptions& png=PngOptions());
+
+    // puts a data file split by encrypt_shards() back together from its
+    // images, given in any order, and saves it as prefix + extension; nothing
+    // is kept if a piece is missing, given twice or fails its checksum
+    Result decrypt_shards(std::vector<std::string> img_filenames,
+                          std::string prefix="decrypted", int threads=0);
+
+    // inspect() for an image file: for a 24-bit BMP only its file header and
+    // the first rows of pixels (as many as the longest header can take up)
+    // are read; other images are decoded
+    Result scan_file(std::string img_filename);
+
+    // the result of a call as one line of JSON: status, header fields and stats
+    std::string to_json(const Result&);
+
+    // verify() for an image file, which is only read (mapped if it is a 24-bit BMP)
+    Result verify_file(std::string img_filename, int threads=0);
+
+    // encrypts an arbitrary file into a bitmap image; the data is embedded by
+    // this many threads (0 = one per hardware thread), deflated first at
+    // level 1..9 (0 = not compressed) and keyed with the key in a key file
+    // (none if empty), saving it as encrypted.bmp or another name (see
+    // encrypt_file()); wraps encrypt_file() and returns its result
+    Result encrypt(std::string, std::string, int lsbs=1, int threads=0, int level=0,
+                   std::string key_filename="", std::string new_img_filename="encrypted.bmp",
+                   const PngOptions& png=PngOptions());
+
+    // decrypts an arbitrary file from an encrypted bitmap image, extracting
+    // with this many threads (0 = one per hardware thread) and the key in a
+    // key file if the data is keyed; wraps Decoder::decrypt_stream() and
+    // returns its result
+    Result decrypt(std::string, int threads=0, std::string key_filename="");
+
+    // checks that version 2 headers with 32-bit dimensions and sizes past
+    // 2^32 bits read back as packed, and that version 1 images (built the
+    // way the original encoder laid them out) still decrypt
+    bool check_headers(unsigned int seed=1);
+
+    // checks that embedding and extracting in bands on several threads gives
+    // the same image, data and checksums as on one, at lsbs 1..7 over bands
+    // that do not split evenly
+    bool check_bands(unsigned int seed=1);
+}
+
+#endif   // !defined _FILE2IMAGESTEGOTOOLS_H_
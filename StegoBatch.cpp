@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoBatch.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: batch encryption from a manifest.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "StegoBatch.h"
+#include "StegoWorkers.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define STEGO_DIRS 1
+    #include <dirent.h>
+    #include <sys/stat.h>
+#endif
+
+namespace f2i_stego_tools {
+
+    //
+    // manifest
+    //
+
+    // splits a manifest line into its fields
+    std::vector<std::string> split_fields(const std::string& line) {
+        std::vector<std::string> fields;
+        if (line.find('\t') != std::string::npos) {
+            std::stringstream ss(line);
+            std::string f;
+            while (std::getline(ss, f, '\t')) fields.push_back(f);
+        } else {
+            std::stringstream ss(line);
+            std::string f;
+            while (ss >> f) fields.push_back(f);
+        }
+        return fields;
+    }
+
+    bool read_manifest(std::string path, std::vector<BatchJob>& jobs, std::string& error) {
+        std::ifstream ifs(path.c_str());
+        if (!ifs) {
+            error = "Manifest could not be opened.";
+            return false;
+        }
+
+        std::string line;
+        for (int n=1; std::getline(ifs, line); n++) {
+            if (!line.empty() && line[line.size()-1] == '\r') line.erase(line.size()-1);
+            if (line.find_first_not_of(" \t") == std::string::npos || line[0] == '#') continue;
+
+            std::vector<std::string> f = split_fields(line);
+            BatchJob job;
+            job.lsbs = f.size() == 4 ? atoi(f[2].c_str()) : 0;
+            // 8 is only for 16-bit carriers, which the encoder checks
+            if (job.lsbs < 1 || job.lsbs > 8) {
+                std::stringstream ss;
+                ss << "Manifest line " << n << " is not \"carrier payload lsbs output\".";
+                error = ss.str();
+                return false;
+            }
+            job.carrier = f[0];
+            job.payload = f[1];
+            job.output = f[3];
+            jobs.push_back(job);
+        }
+        return true;
+    }
+
+    //
+    // work-stealing queues
+    //
+
+    // job indices owned by one thread: the owner takes from the front, other
+    // threads steal from the back
+    struct JobQueue {
+        std::mutex m;
+        std::deque<int> jobs;
+
+        bool take(int& job) {
+            std::lock_guard<std::mutex> lock(m);
+            if (jobs.empty()) return false;
+            job = jobs.front();
+            jobs.pop_front();
+            return true;
+        }
+
+        bool steal(int& job) {
+            std::lock_guard<std::mutex> lock(m);
+            if (jobs.empty()) return false;
+            job = jobs.back();
+            jobs.pop_back();
+            return true;
+        }
+    };
+
+    BatchReport run_batch(const std::vector<BatchJob>& jobs, std::vector<Result>& results,
+                          int threads, const PngOptions& png) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+        if (threads > (int)jobs.size()) threads = jobs.empty() ? 1 : (int)jobs.size();
+        results.assign(jobs.size(), Result());
+
+        // deal the jobs out round robin
+        std::vector<JobQueue> queues(threads);
+        for (int i=0; i<(int)jobs.size(); i++) queues[i % threads].jobs.push_back(i);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // parallelism comes from running jobs side by side, so every encoder
+        // embeds on a single thread
+        auto worker = [&](int t) {
+            Encoder encoder(1, 1);
+            int job;
+            for (;;) {
+                bool found = queues[t].take(job);
+                for (int k=1; !found && k<threads; k++)
+                    found = queues[(t + k) % threads].steal(job);
+                if (!found) return;
+
+                const BatchJob& j = jobs[job];
+                encoder.set_lsbs(j.lsbs);
+                results[job] = encrypt_file(encoder, j.carrier, j.payload, j.output, png);
+            }
+        };
+        Workers pool;
+        pool.run(threads, worker);
+
+        BatchReport report;
+        report.jobs = (int)jobs.size();
+        report.failed = 0;
+        report.bytes = 0;
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (int i=0; i<(int)results.size(); i++) {
+            if (results[i].status == SUCCESS) report.bytes += results[i].f_bytes;
+            else report.failed++;
+        }
+        return report;
+    }
+
+    //
+    // scan
+    //
+
+    // appends path to files if it is a file, or every file under it if it
+    // is a directory (without directory support, paths are taken as files)
+    void list_files(const std::string& path, std::vector<std::string>& files) {
+#ifdef STEGO_DIRS
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0) return;
+        if (S_ISREG(st.st_mode) || (S_ISLNK(st.st_mode) && stat(path.c_str(), &st) == 0 &&
+                                    S_ISREG(st.st_mode))) {
+            files.push_back(path);
+            return;
+        }
+        if (!S_ISDIR(st.st_mode)) return;
+
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return;
+        std::vector<std::string> names;
+        while (struct dirent* e = readdir(dir)) {
+            std::string name = e->d_name;
+            if (name != "." && name != "..") names.push_back(name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        std::string prefix = path[path.size()-1] == '/' ? path : path + "/";
+        for (int i=0; i<(int)names.size(); i++) list_files(prefix + names[i], files);
+#else
+        files.push_back(path);
+#endif
+    }
+
+    int scan_images(const std::vector<std::string>& paths, std::vector<std::string>& files,
+                    std::vector<Result>& results, int threads) {
+        files.clear();
+        for (int i=0; i<(int)paths.size(); i++) list_files(paths[i], files);
+        results.assign(files.size(), Result());
+
+        // threads just claim the next file, so the reads of different files overlap
+        parallel_for((int)files.size(), threads, [&](int i) {
+            results[i] = scan_file(files[i]);
+        });
+
+        int carriers = 0;
+        for (int i=0; i<(int)results.size(); i++)
+            if (results[i].status == SUCCESS) carriers++;
+        return carriers;
+    }
+}
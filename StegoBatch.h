@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoBatch.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: batch encryption from a manifest.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOBATCH_H_
+#define _STEGOBATCH_H_
+
+#include <string>
+#include <vector>
+#include "File2ImageStegoTools.h"
+
+namespace f2i_stego_tools {
+
+    // one line of a manifest: encrypt payload into carrier, save as output
+    struct BatchJob {
+        std::string carrier;
+        std::string payload;
+        int lsbs;
+        std::string output;
+    };
+
+    // totals of a batch run
+    struct BatchReport {
+        int jobs;                       // jobs run
+        int failed;                     // jobs that did not succeed
+        unsigned long long bytes;       // payload bytes embedded
+        double seconds;                 // wall time of the whole batch
+    };
+
+    // reads a manifest with one job per line: carrier, payload, lsbs and
+    // output path, separated by tabs (or by spaces if the line has no tabs);
+    // blank lines and lines starting with '#' are skipped. Returns false and
+    // names the offending line in error if the file cannot be read or parsed
+    bool read_manifest(std::string path, std::vector<BatchJob>& jobs, std::string& error);
+
+    // runs the jobs on this many threads (0 = one per hardware thread); each
+    // thread runs whole jobs with its own Encoder and steals queued jobs from
+    // the others when its own queue runs dry, so one thread's decode, embed
+    // and save overlap with the others'. Outputs named .png are written with
+    // these options. results[i] is the outcome of jobs[i]
+    BatchReport run_batch(const std::vector<BatchJob>& jobs, std::vector<Result>& results,
+                          int threads=0, const PngOptions& png=PngOptions());
+
+    // lists the files under paths (files as they are, directories searched
+    // recursively without following links) and runs scan_file() on each on
+    // this many threads (0 = one per hardware thread), which reads only the
+    // first rows of 24-bit BMPs but decodes PNGs and other images in full;
+    // results[i] is the header of files[i] if it carries data. Returns the
+    // number of carriers
+    int scan_images(const std::vector<std::string>& paths, std::vector<std::string>& files,
+                    std::vector<Result>& results, int threads=0);
+}
+
+#endif   // !defined _STEGOBATCH_H_
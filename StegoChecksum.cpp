@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoChecksum.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: CRC32C payload checksum.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "StegoChecksum.h"
+
+#include <vector>
+#include <cstring>
+#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define STEGO_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+// lets a single function use instructions the rest of the file is not compiled for
+#if defined(__GNUC__)
+    #define STEGO_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define STEGO_TARGET(isa)
+#endif
+
+namespace f2i_stego_tools {
+
+    //
+    // helpers
+    //
+
+    // CRC32C polynomial, bit-reversed
+    const unsigned int CRC32C_POLY = 0x82f63b78;
+
+    // CRC of n bytes given the running (inverted) register value
+    typedef unsigned int (*CrcUpdate)(unsigned int reg, const unsigned char* data, unsigned long n);
+
+    // slice-by-8 tables: table[k][b] is the CRC of byte b followed by k zero bytes
+    struct CrcTables {
+        unsigned int table[8][256];
+
+        CrcTables() {
+            for (unsigned int b=0; b<256; b++) {
+                unsigned int c = b;
+                for (int i=0; i<8; i++) c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+                table[0][b] = c;
+            }
+            for (unsigned int b=0; b<256; b++)
+                for (int k=1; k<8; k++)
+                    table[k][b] = (table[k-1][b] >> 8) ^ table[0][table[k-1][b] & 0xff];
+        }
+    };
+
+    const CrcTables& crc_tables() {
+        static const CrcTables tables;
+        return tables;
+    }
+
+    //
+    // slice-by-8, 8 bytes per step
+    //
+
+    unsigned int crc_slice8(unsigned int reg, const unsigned char* data, unsigned long n) {
+        const unsigned int (*t)[256] = crc_tables().table;
+        for (; n >= 8; n -= 8, data += 8) {
+            unsigned int lo = reg ^ (data[0] | data[1] << 8 | data[2] << 16 | (unsigned int)data[3] << 24);
+            unsigned int hi = data[4] | data[5] << 8 | data[6] << 16 | (unsigned int)data[7] << 24;
+            reg = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+                  t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        }
+        for (; n > 0; n--, data++) reg = (reg >> 8) ^ t[0][(reg ^ *data) & 0xff];
+        return reg;
+    }
+
+#ifdef STEGO_X86
+
+    //
+    // SSE4.2: the CRC32 instruction, 8 bytes per step
+    //
+
+    STEGO_TARGET("sse4.2")
+    unsigned int crc_sse42(unsigned int reg, const unsigned char* data, unsigned long n) {
+        unsigned long long r = reg;
+        for (; n >= 8; n -= 8, data += 8) {
+            unsigned long long v;
+            memcpy(&v, data, 8);
+            r = _mm_crc32_u64(r, v);
+        }
+        unsigned int r32 = (unsigned int)r;
+        for (; n > 0; n--, data++) r32 = _mm_crc32_u8(r32, *data);
+        return r32;
+    }
+
+    bool has_sse42() {
+    #if defined(__GNUC__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2") != 0;
+    #elif defined(_MSC_VER)
+        int r[4];
+        __cpuid(r, 1);
+        return (r[2] & (1 << 20)) != 0;
+    #else
+        return false;
+    #endif
+    }
+
+#endif // STEGO_X86
+
+    //
+    // dispatch
+    //
+
+    CrcUpdate best_crc() {
+    #ifdef STEGO_X86
+        if (has_sse42()) return crc_sse42;
+    #endif
+        return crc_slice8;
+    }
+
+    unsigned int crc32c(unsigned int crc, const unsigned char* data, unsigned long n) {
+        static const CrcUpdate update = best_crc();
+        return ~update(~crc, data, n);
+    }
+
+    //
+    // combine
+    //
+
+    // multiplies a 32x32 matrix over GF(2) by a vector
+    unsigned int gf2_times(const unsigned int* mat, unsigned int vec) {
+        unsigned int sum = 0;
+        for (; vec; vec >>= 1, mat++)
+            if (vec & 1) sum ^= *mat;
+        return sum;
+    }
+
+    void gf2_square(unsigned int* square, const unsigned int* mat) {
+        for (int n=0; n<32; n++) square[n] = gf2_times(mat, mat[n]);
+    }
+
+    unsigned int crc32c_combine(unsigned int crc1, unsigned int crc2, unsigned long long len2) {
+        if (len2 == 0) return crc1;
+
+        // operator for one zero bit, then squared up to one zero byte
+        unsigned int even[32], odd[32];
+        odd[0] = CRC32C_POLY;
+        for (int n=1; n<32; n++) odd[n] = 1u << (n - 1);
+        gf2_square(even, odd);  // 2 zero bits
+        gf2_square(odd, even);  // 4 zero bits
+
+        // runs crc1 through len2 zero bytes, a power of two at a time
+        do {
+            gf2_square(even, odd);
+            if (len2 & 1) crc1 = gf2_times(even, crc1);
+            len2 >>= 1;
+            if (!len2) break;
+            gf2_square(odd, even);
+            if (len2 & 1) crc1 = gf2_times(odd, crc1);
+            len2 >>= 1;
+        } while (len2);
+        return crc1 ^ crc2;
+    }
+
+    bool check_crc32c(unsigned int seed) {
+        if (crc32c(0, (const unsigned char*)"123456789", 9) != 0xe3069283) return false;
+
+        std::mt19937 rng(seed);
+        for (int round=0; round<64; round++) {
+            std::vector<unsigned char> data(rng() % 3000 + 1);
+            for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)rng();
+            unsigned long n = (unsigned long)data.size(), cut = rng() % n;
+
+            // the instruction (if any) against the tables, and a run split in two
+            unsigned int whole = crc32c(0, &data[0], n);
+            if (whole != ~crc_slice8(~0u, &data[0], n)) return false;
+            unsigned int a = crc32c(0, &data[0], cut), b = crc32c(0, &data[cut], n - cut);
+            if (crc32c(a, &data[cut], n - cut) != whole) return false;
+            if (crc32c_combine(a, b, n - cut) != whole) return false;
+        }
+        return true;
+    }
+}
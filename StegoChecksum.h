@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoChecksum.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: CRC32C payload checksum.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOCHECKSUM_H_
+#define _STEGOCHECKSUM_H_
+
+namespace f2i_stego_tools {
+
+    // CRC32C (Castagnoli) of n more bytes, continuing from the CRC of the
+    // bytes before them (0 to start); uses the SSE4.2 CRC32 instruction
+    // when the CPU has it and slice-by-8 tables otherwise
+    unsigned int crc32c(unsigned int crc, const unsigned char* data, unsigned long n);
+
+    // CRC of two runs of bytes back to back, given the CRC of each and the
+    // length of the second, so separate threads can each checksum their own run
+    unsigned int crc32c_combine(unsigned int crc1, unsigned int crc2, unsigned long long len2);
+
+    // checks the CRC against the published "123456789" value and the
+    // instruction against the tables on random runs; returns false on any mismatch
+    bool check_crc32c(unsigned int seed=1);
+}
+
+#endif   // !defined _STEGOCHECKSUM_H_
@@ -0,0 +1,332 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoCipher.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: ChaCha20 keystream.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "StegoCipher.h"
+#include "StegoKernels.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define STEGO_X86 1
+    #include <immintrin.h>
+#endif
+
+// lets a single function use instructions the rest of the file is not compiled for
+#if defined(__GNUC__)
+    #define STEGO_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define STEGO_TARGET(isa)
+#endif
+
+// the 20 rounds (10 column + diagonal double rounds) over a state of 16
+// words x, whatever a word is (one block, or one lane per block)
+#define CHACHA_QUARTER(x, a, b, c, d, ADD, XOR, ROTL) \
+    x[a] = ADD(x[a], x[b]); x[d] = ROTL(XOR(x[d], x[a]), 16); \
+    x[c] = ADD(x[c], x[d]); x[b] = ROTL(XOR(x[b], x[c]), 12); \
+    x[a] = ADD(x[a], x[b]); x[d] = ROTL(XOR(x[d], x[a]), 8);  \
+    x[c] = ADD(x[c], x[d]); x[b] = ROTL(XOR(x[b], x[c]), 7);
+
+#define CHACHA_ROUNDS(x, ADD, XOR, ROTL) \
+    for (int round=0; round<10; round++) { \
+        CHACHA_QUARTER(x, 0, 4,  8, 12, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 1, 5,  9, 13, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 2, 6, 10, 14, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 3, 7, 11, 15, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 0, 5, 10, 15, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 1, 6, 11, 12, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 2, 7,  8, 13, ADD, XOR, ROTL) \
+        CHACHA_QUARTER(x, 3, 4,  9, 14, ADD, XOR, ROTL) \
+    }
+
+namespace f2i_stego_tools {
+
+    //
+    // helpers
+    //
+
+    // "expand 32-byte k"
+    const unsigned int CHACHA_SIGMA[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+
+    // generates some number of consecutive 64 byte blocks, the first one at
+    // the counter in words 12 and 13 of the state
+    typedef void (*BlockGenerator)(const unsigned int* state, unsigned char* out);
+
+    // block generator for one instruction set
+    struct KeystreamGenerator {
+        const char* name;
+        int blocks;     // blocks per call
+        BlockGenerator generate;
+    };
+
+    inline void chacha_store32(unsigned char* p, unsigned int v) {
+        p[0] = (unsigned char)v;
+        p[1] = (unsigned char)(v >> 8);
+        p[2] = (unsigned char)(v >> 16);
+        p[3] = (unsigned char)(v >> 24);
+    }
+
+    // counter of the k-th block after the state's own, split into two words
+    inline unsigned int counter_lo(const unsigned int* s, int k) {
+        return (unsigned int)((s[12] | (unsigned long long)s[13] << 32) + k);
+    }
+
+    inline unsigned int counter_hi(const unsigned int* s, int k) {
+        return (unsigned int)(((s[12] | (unsigned long long)s[13] << 32) + k) >> 32);
+    }
+
+    //
+    // scalar reference, one block at a time
+    //
+
+    #define SCALAR_ADD(a, b) ((a) + (b))
+    #define SCALAR_XOR(a, b) ((a) ^ (b))
+    #define SCALAR_ROTL(v, n) ((v) << (n) | (v) >> (32 - (n)))
+
+    void chacha_scalar(const unsigned int* s, unsigned char* out) {
+        unsigned int x[16];
+        memcpy(x, s, sizeof(x));
+        CHACHA_ROUNDS(x, SCALAR_ADD, SCALAR_XOR, SCALAR_ROTL)
+        for (int i=0; i<16; i++) chacha_store32(out + 4*i, x[i] + s[i]);
+    }
+
+#ifdef STEGO_X86
+
+    //
+    // SSE2: 4 blocks per call, one block per 32 bit lane
+    //
+
+    #define SSE2_ROTL(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+    void chacha_sse2(const unsigned int* s, unsigned char* out) {
+        __m128i x[16], in[16];
+        for (int i=0; i<16; i++) in[i] = _mm_set1_epi32((int)s[i]);
+        in[12] = _mm_set_epi32((int)counter_lo(s, 3), (int)counter_lo(s, 2),
+                               (int)counter_lo(s, 1), (int)counter_lo(s, 0));
+        in[13] = _mm_set_epi32((int)counter_hi(s, 3), (int)counter_hi(s, 2),
+                               (int)counter_hi(s, 1), (int)counter_hi(s, 0));
+        memcpy(x, in, sizeof(x));
+        CHACHA_ROUNDS(x, _mm_add_epi32, _mm_xor_si128, SSE2_ROTL)
+
+        // lanes to blocks: transpose each group of 4 words
+        for (int g=0; g<4; g++) {
+            __m128i a = _mm_add_epi32(x[4*g], in[4*g]), b = _mm_add_epi32(x[4*g+1], in[4*g+1]);
+            __m128i c = _mm_add_epi32(x[4*g+2], in[4*g+2]), d = _mm_add_epi32(x[4*g+3], in[4*g+3]);
+            __m128i ab0 = _mm_unpacklo_epi32(a, b), ab1 = _mm_unpackhi_epi32(a, b);
+            __m128i cd0 = _mm_unpacklo_epi32(c, d), cd1 = _mm_unpackhi_epi32(c, d);
+            _mm_storeu_si128((__m128i*)(out + 0*64 + 16*g), _mm_unpacklo_epi64(ab0, cd0));
+            _mm_storeu_si128((__m128i*)(out + 1*64 + 16*g), _mm_unpackhi_epi64(ab0, cd0));
+            _mm_storeu_si128((__m128i*)(out + 2*64 + 16*g), _mm_unpacklo_epi64(ab1, cd1));
+            _mm_storeu_si128((__m128i*)(out + 3*64 + 16*g), _mm_unpackhi_epi64(ab1, cd1));
+        }
+    }
+
+    //
+    // AVX2: 8 blocks per call; rotations by whole bytes are shuffles
+    //
+
+    #define AVX2_ROTL(v, n) \
+        ((n) == 16 ? _mm256_shuffle_epi8(v, rot16) : (n) == 8 ? _mm256_shuffle_epi8(v, rot8) : \
+         _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n))))
+
+    STEGO_TARGET("avx2")
+    void chacha_avx2(const unsigned int* s, unsigned char* out) {
+        const __m256i rot16 = _mm256_setr_epi8(2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13,
+                                               2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13);
+        const __m256i rot8 = _mm256_setr_epi8(3,0,1,2, 7,4,5,6, 11,8,9,10, 15,12,13,14,
+                                              3,0,1,2, 7,4,5,6, 11,8,9,10, 15,12,13,14);
+        __m256i x[16], in[16];
+        for (int i=0; i<16; i++) in[i] = _mm256_set1_epi32((int)s[i]);
+        in[12] = _mm256_setr_epi32((int)counter_lo(s, 0), (int)counter_lo(s, 1),
+                                   (int)counter_lo(s, 2), (int)counter_lo(s, 3),
+                                   (int)counter_lo(s, 4), (int)counter_lo(s, 5),
+                                   (int)counter_lo(s, 6), (int)counter_lo(s, 7));
+        in[13] = _mm256_setr_epi32((int)counter_hi(s, 0), (int)counter_hi(s, 1),
+                                   (int)counter_hi(s, 2), (int)counter_hi(s, 3),
+                                   (int)counter_hi(s, 4), (int)counter_hi(s, 5),
+                                   (int)counter_hi(s, 6), (int)counter_hi(s, 7));
+        memcpy(x, in, sizeof(x));
+        CHACHA_ROUNDS(x, _mm256_add_epi32, _mm256_xor_si256, AVX2_ROTL)
+
+        // the same transpose within each 128 bit half: the low half holds
+        // blocks 0..3, the high half blocks 4..7
+        for (int g=0; g<4; g++) {
+            __m256i a = _mm256_add_epi32(x[4*g], in[4*g]), b = _mm256_add_epi32(x[4*g+1], in[4*g+1]);
+            __m256i c = _mm256_add_epi32(x[4*g+2], in[4*g+2]), d = _mm256_add_epi32(x[4*g+3], in[4*g+3]);
+            __m256i ab0 = _mm256_unpacklo_epi32(a, b), ab1 = _mm256_unpackhi_epi32(a, b);
+            __m256i cd0 = _mm256_unpacklo_epi32(c, d), cd1 = _mm256_unpackhi_epi32(c, d);
+            __m256i t[4] = { _mm256_unpacklo_epi64(ab0, cd0), _mm256_unpackhi_epi64(ab0, cd0),
+                             _mm256_unpacklo_epi64(ab1, cd1), _mm256_unpackhi_epi64(ab1, cd1) };
+            for (int k=0; k<4; k++) {
+                _mm_storeu_si128((__m128i*)(out + k*64 + 16*g), _mm256_castsi256_si128(t[k]));
+                _mm_storeu_si128((__m128i*)(out + (k+4)*64 + 16*g), _mm256_extracti128_si256(t[k], 1));
+            }
+        }
+    }
+
+#endif // STEGO_X86
+
+    //
+    // dispatch
+    //
+
+    // every generator the running CPU supports, narrowest (the scalar reference) first
+    std::vector<KeystreamGenerator> supported_generators() {
+        std::vector<KeystreamGenerator> g;
+        KeystreamGenerator scalar = {"scalar", 1, chacha_scalar};
+        g.push_back(scalar);
+    #ifdef STEGO_X86
+        bool avx2, bmi2;
+        detect_cpu(avx2, bmi2);
+        KeystreamGenerator sse2 = {"sse2", 4, chacha_sse2};
+        g.push_back(sse2);
+        if (avx2) {
+            KeystreamGenerator a = {"avx2", 8, chacha_avx2};
+            g.push_back(a);
+        }
+    #endif
+        return g;
+    }
+
+    const std::vector<KeystreamGenerator>& generators() {
+        static const std::vector<KeystreamGenerator> all = supported_generators();
+        return all;
+    }
+
+    //
+    // Keystream
+    //
+
+    Keystream::Keystream() : nonce_(0) {
+        memset(key, 0, sizeof(key));
+    }
+
+    void Keystream::set_key(const unsigned char* k) {
+        for (int i=0; i<8; i++)
+            key[i] = k[4*i] | k[4*i+1] << 8 | k[4*i+2] << 16 | (unsigned int)k[4*i+3] << 24;
+    }
+
+    void Keystream::apply(unsigned char* data, unsigned long n, unsigned long long offset) const {
+        const std::vector<KeystreamGenerator>& all = generators();
+        unsigned int s[16];
+        memcpy(s, CHACHA_SIGMA, sizeof(CHACHA_SIGMA));
+        memcpy(s + 4, key, sizeof(key));
+        s[14] = (unsigned int)nonce_;
+        s[15] = (unsigned int)(nonce_ >> 32);
+
+        unsigned long long counter = offset / 64;
+        unsigned long skip = (unsigned long)(offset % 64);
+        unsigned char ks[8*64];
+        while (n > 0) {
+            // the widest generator that does not run past the data
+            unsigned long need = (skip + n + 63) / 64;
+            int k = (int)all.size() - 1;
+            while (k > 0 && (unsigned long)all[k].blocks > need) k--;
+
+            s[12] = (unsigned int)counter;
+            s[13] = (unsigned int)(counter >> 32);
+            all[k].generate(s, ks);
+
+            unsigned long take = all[k].blocks*64 - skip;
+            if (take > n) take = n;
+            const unsigned char* key_bytes = ks + skip;
+            unsigned long i = 0;
+            for (; i+8 <= take; i += 8) {
+                unsigned long long a, b;
+                memcpy(&a, data + i, 8);
+                memcpy(&b, key_bytes + i, 8);
+                a ^= b;
+                memcpy(data + i, &a, 8);
+            }
+            for (; i<take; i++) data[i] ^= key_bytes[i];
+
+            data += take;
+            n -= take;
+            counter += all[k].blocks;
+            skip = 0;
+        }
+    }
+
+    bool load_key(std::string filename, unsigned char* key) {
+        std::ifstream ifs(filename.c_str(), std::ios::binary|std::ios::in);
+        char buf[KEY_BYTES + 1];
+        if (!ifs) return false;
+        ifs.read(buf, sizeof(buf));
+        if (ifs.bad() || ifs.gcount() != KEY_BYTES) return false;
+        memcpy(key, buf, KEY_BYTES);
+        return true;
+    }
+
+    bool check_keystream(unsigned int seed) {
+
+        // all-zero key and nonce, block 0
+        static const unsigned char zero_block[64] = {
+            0x76,0xb8,0xe0,0xad,0xa0,0xf1,0x3d,0x90,0x40,0x5d,0x6a,0xe5,0x53,0x86,0xbd,0x28,
+            0xbd,0xd2,0x19,0xb8,0xa0,0x8d,0xed,0x1a,0xa8,0x36,0xef,0xcc,0x8b,0x77,0x0d,0xc7,
+            0xda,0x41,0x59,0x7c,0x51,0x57,0x48,0x8d,0x77,0x24,0xe0,0x3f,0xb8,0xd8,0x4a,0x37,
+            0x6a,0x43,0xb8,0xf4,0x15,0x18,0xa1,0x1c,0xc3,0x87,0xb6,0x69,0xb2,0xee,0x65,0x86 };
+        Keystream zero;
+        unsigned char block[64];
+        memset(block, 0, sizeof(block));
+        zero.apply(block, sizeof(block), 0);
+        if (memcmp(block, zero_block, sizeof(block)) != 0) return false;
+
+        std::mt19937 rng(seed);
+        const std::vector<KeystreamGenerator>& all = generators();
+        for (int round=0; round<64; round++) {
+            unsigned int s[16];
+            for (int i=0; i<16; i++) s[i] = rng();
+            // counters that carry into the high word
+            if (round % 4 == 0) s[12] = 0xfffffffd;
+
+            // every generator against the scalar one, block by block
+            for (int k=1; k<(int)all.size(); k++) {
+                unsigned char got[8*64], want[64];
+                all[k].generate(s, got);
+                for (int b=0; b<all[k].blocks; b++) {
+                    unsigned int t[16];
+                    memcpy(t, s, sizeof(t));
+                    t[12] = counter_lo(s, b);
+                    t[13] = counter_hi(s, b);
+                    chacha_scalar(t, want);
+                    if (memcmp(got + 64*b, want, 64) != 0) return false;
+                }
+            }
+
+            // a stretch at an odd offset against the same stretch of a longer run
+            unsigned char k_bytes[KEY_BYTES];
+            for (int i=0; i<KEY_BYTES; i++) k_bytes[i] = (unsigned char)rng();
+            Keystream ks;
+            ks.set_key(k_bytes);
+            ks.set_nonce((unsigned long long)rng() << 32 | rng());
+            unsigned long offset = rng() % 1000, n = rng() % 1500;
+            std::vector<unsigned char> whole(offset + n + 1, 0), part(n + 1, 0);
+            ks.apply(&whole[0], (unsigned long)whole.size(), 0);
+            ks.apply(&part[0], n, offset);
+            if (n && memcmp(&part[0], &whole[offset], n) != 0) return false;
+        }
+        return true;
+    }
+}
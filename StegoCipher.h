@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoCipher.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: ChaCha20 keystream.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOCIPHER_H_
+#define _STEGOCIPHER_H_
+
+#include <string>
+
+namespace f2i_stego_tools {
+
+    // bytes in a key
+    const int KEY_BYTES = 32;
+
+    // ChaCha20 keystream (64-bit nonce, 64-bit block counter) that can be
+    // applied at any byte offset, so separate threads and blocks of a data
+    // file each XOR their own part of it in place
+    class Keystream {
+    public:
+        Keystream();
+
+        // key of KEY_BYTES bytes
+        void set_key(const unsigned char* key);
+
+        // nonce of the next stream; never use one twice with the same key
+        void set_nonce(unsigned long long n) { nonce_ = n; }
+        unsigned long long nonce() const { return nonce_; }
+
+        // XORs n bytes of data with the keystream, data[0] being stream byte offset
+        void apply(unsigned char* data, unsigned long n, unsigned long long offset) const;
+
+    private:
+        unsigned int key[8];
+        unsigned long long nonce_;
+    };
+
+    // reads a key file holding exactly KEY_BYTES bytes
+    bool load_key(std::string, unsigned char* key);
+
+    // checks the keystream against the published zero key test vector and
+    // every supported vector width against the scalar one at odd offsets
+    bool check_keystream(unsigned int seed=1);
+}
+
+#endif   // !defined _STEGOCIPHER_H_
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoCompress.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: streaming payload compression.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "StegoCompress.h"
+
+#include <cstring>
+#include <zlib.h>
+
+namespace f2i_stego_tools {
+
+    // uncompressed data goes through zlib in pieces of this size
+    const unsigned long Z_BLOCK_SIZE = 256 << 10;
+
+    //
+    // Deflater
+    //
+
+    Deflater::Deflater()
+        : z(NULL), level(0), eof(false), done(false), raw(0), grown(0) {
+    }
+
+    Deflater::~Deflater() {
+        if (z) {
+            deflateEnd(z);
+            delete z;
+        }
+    }
+
+    bool Deflater::begin(std::function<long(unsigned char*, unsigned long)> src, int lvl) {
+        if (lvl < 1 || lvl > 9) return false;
+
+        // the zlib state is reset, not rebuilt, unless the level changes
+        if (z && level != lvl) {
+            deflateEnd(z);
+            delete z;
+            z = NULL;
+        }
+        if (!z) {
+            z = new z_stream;
+            memset(z, 0, sizeof(z_stream));
+            if (deflateInit(z, lvl) != Z_OK) {
+                delete z;
+                z = NULL;
+                return false;
+            }
+            level = lvl;
+            grown += 2;
+        } else if (deflateReset(z) != Z_OK) {
+            return false;
+        }
+        if (in.size() < Z_BLOCK_SIZE) {
+            in.resize(Z_BLOCK_SIZE);
+            grown++;
+        }
+        source = src;
+        z->avail_in = 0;
+        eof = done = false;
+        raw = 0;
+        return true;
+    }
+
+    long Deflater::read(unsigned char* buf, unsigned long n) {
+        if (!z) return -1;
+        z->next_out = buf;
+        z->avail_out = (uInt)n;
+        while (z->avail_out > 0 && !done) {
+            if (z->avail_in == 0 && !eof) {
+                long k = source(&in[0], Z_BLOCK_SIZE);
+                if (k < 0) return -1;
+                if (k == 0) eof = true;
+                raw += k;
+                z->next_in = &in[0];
+                z->avail_in = (uInt)k;
+            }
+            int ret = deflate(z, eof ? Z_FINISH : Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) done = true;
+            else if (ret != Z_OK && ret != Z_BUF_ERROR) return -1;
+        }
+        return (long)(n - z->avail_out);
+    }
+
+    //
+    // Inflater
+    //
+
+    Inflater::Inflater()
+        : z(NULL), done(false), raw(0), grown(0) {
+    }
+
+    Inflater::~Inflater() {
+        if (z) {
+            inflateEnd(z);
+            delete z;
+        }
+    }
+
+    bool Inflater::begin(std::function<bool(const unsigned char*, unsigned long)> snk) {
+        if (!z) {
+            z = new z_stream;
+            memset(z, 0, sizeof(z_stream));
+            if (inflateInit(z) != Z_OK) {
+                delete z;
+                z = NULL;
+                return false;
+            }
+            grown += 2;
+        } else if (inflateReset(z) != Z_OK) {
+            return false;
+        }
+        if (out.size() < Z_BLOCK_SIZE) {
+            out.resize(Z_BLOCK_SIZE);
+            grown++;
+        }
+        sink = snk;
+        done = false;
+        raw = 0;
+        return true;
+    }
+
+    bool Inflater::write(const unsigned char* data, unsigned long n) {
+        if (!z) return false;
+        z->next_in = (Bytef*)data;
+        z->avail_in = (uInt)n;
+
+        // keep going while there is input or the output buffer came back
+        // full (more may be pending); nothing may follow the end of the stream
+        while (z->avail_in > 0 || z->avail_out == 0) {
+            if (done) return z->avail_in == 0;
+            z->next_out = &out[0];
+            z->avail_out = (uInt)Z_BLOCK_SIZE;
+            int ret = inflate(z, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) done = true;
+            else if (ret == Z_BUF_ERROR && z->avail_in == 0) break;
+            else if (ret != Z_OK) return false;
+            unsigned long k = Z_BLOCK_SIZE - z->avail_out;
+            if (k > 0 && !sink(&out[0], k)) return false;
+            raw += k;
+        }
+        return true;
+    }
+}
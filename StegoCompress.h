@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoCompress.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: streaming payload compression.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOCOMPRESS_H_
+#define _STEGOCOMPRESS_H_
+
+#include <vector>
+#include <functional>
+
+// zlib's stream state, kept out of this header
+struct z_stream_s;
+
+namespace f2i_stego_tools {
+
+    // compresses (zlib format) data pulled from a source, handing out the
+    // compressed bytes through read(); the zlib state and input buffer are
+    // kept for the next stream
+    class Deflater {
+    public:
+        Deflater();
+        ~Deflater();
+
+        // starts a new stream over source (see DataSource) at this level (1..9)
+        bool begin(std::function<long(unsigned char*, unsigned long)> source, int level);
+
+        // fills up to n bytes of buf with compressed data; returns how many
+        // (0 once the stream is finished, negative on an error)
+        long read(unsigned char* buf, unsigned long n);
+
+        // bytes taken from the source so far
+        unsigned long long raw_bytes() const { return raw; }
+
+        // heap allocations made so far for buffers and zlib state
+        unsigned long long allocations() const { return grown; }
+
+    private:
+        // not copyable
+        Deflater(const Deflater&);
+        Deflater& operator=(const Deflater&);
+
+        z_stream_s* z;
+        int level;
+        std::function<long(unsigned char*, unsigned long)> source;
+        std::vector<unsigned char> in;
+        bool eof, done;
+        unsigned long long raw;
+        unsigned long long grown;
+    };
+
+    // decompresses data written to it, passing the result on to a sink
+    class Inflater {
+    public:
+        Inflater();
+        ~Inflater();
+
+        // starts a new stream into sink (see DataSink)
+        bool begin(std::function<bool(const unsigned char*, unsigned long)> sink);
+
+        // decompresses the next n bytes; false on corrupt data or a sink error
+        bool write(const unsigned char* data, unsigned long n);
+
+        // true if the stream ended where it should
+        bool finish() const { return done; }
+
+        // decompressed bytes handed to the sink so far
+        unsigned long long raw_bytes() const { return raw; }
+
+        // heap allocations made so far for buffers and zlib state
+        unsigned long long allocations() const { return grown; }
+
+    private:
+        // not copyable
+        Inflater(const Inflater&);
+        Inflater& operator=(const Inflater&);
+
+        z_stream_s* z;
+        std::function<bool(const unsigned char*, unsigned long)> sink;
+        std::vector<unsigned char> out;
+        bool done;
+        unsigned long long raw;
+        unsigned long long grown;
+    };
+
+    // most bytes a zlib stream of n bytes can inflate to
+    inline unsigned long long max_inflated(unsigned long long n) { return n * 1032 + 64; }
+}
+
+#endif   // !defined _STEGOCOMPRESS_H_
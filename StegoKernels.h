@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoKernels.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: LSB embed/extract kernels.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOKERNELS_H_
+#define _STEGOKERNELS_H_
+
+#include <vector>
+
+namespace f2i_stego_tools {
+
+    // reads n (<= 8) bits from a little-endian bit stream
+    inline unsigned int read_bits(const unsigned char* src, unsigned long long pos, int n) {
+        unsigned int v = src[pos >> 3] >> (pos & 7);
+        if ((pos & 7) + n > 8) v |= (unsigned int)src[(pos >> 3) + 1] << (8 - (pos & 7));
+        return v & ((1u << n) - 1);
+    }
+
+    // writes n (<= 8) bits into a little-endian bit stream
+    inline void write_bits(unsigned char* dst, unsigned long long pos, unsigned int v, int n) {
+        unsigned char* p = dst + (pos >> 3);
+        int r = (int)(pos & 7);
+        unsigned int m = ((1u << n) - 1) << r;
+        v <<= r;
+        p[0] = (unsigned char)((p[0] & ~m) | v);
+        if (r + n > 8) p[1] = (unsigned char)((p[1] & ~(m >> 8)) | (v >> 8));
+    }
+
+    // writes lsbs bits from src (starting at bit src_pos, least significant bit
+    // first) into the low bits of each of the n carrier bytes; src is not read
+    // past the byte holding the last bit used
+    typedef void (*EmbedKernel)(unsigned char* carrier, unsigned long n,
+                                const unsigned char* src, unsigned long long src_pos);
+
+    // packs the low lsbs bits of each of the n carrier bytes into dst (starting
+    // at bit dst_pos); bits of dst outside the written range are preserved
+    typedef void (*ExtractKernel)(const unsigned char* carrier, unsigned long n,
+                                  unsigned char* dst, unsigned long long dst_pos);
+
+    // embed/extract kernels for one instruction set, compiled once per lsbs
+    // value and indexed by it (1..7, and 8 for the low byte of 16-bit samples)
+    struct Kernels {
+        const char* name;
+        EmbedKernel embed[9];
+        ExtractKernel extract[9];
+    };
+
+    // fastest kernels the running CPU supports (picked once via CPUID)
+    const Kernels& best_kernels();
+
+    // every kernel set the running CPU supports, the scalar reference first
+    std::vector<Kernels> supported_kernels();
+
+    // whether the running CPU (and OS) support AVX2 and BMI2 (x86-64 builds only)
+    void detect_cpu(bool& avx2, bool& bmi2);
+
+    // measures embed and extract throughput (carrier bytes per second) of a
+    // kernel set for one lsbs value over a buffer of the given size
+    void bench_kernels(const Kernels&, int lsbs, unsigned long bytes,
+                       double& embed_bps, double& extract_bps);
+
+    // runs every supported kernel set against the scalar reference on random
+    // carriers and payloads for all lsbs 1..8; returns false on any mismatch
+    bool check_kernels(unsigned int seed=1);
+}
+
+#endif   // !defined _STEGOKERNELS_H_
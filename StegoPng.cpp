@@ -0,0 +1,496 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoPng.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: in-process PNG carrier codec.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "StegoPng.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <zlib.h>
+
+namespace f2i_stego_tools {
+
+    //
+    // helpers
+    //
+
+    const unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    // compressed image data is written in IDAT chunks of (up to) this size
+    const unsigned long PNG_CHUNK_SIZE = 256 << 10;
+
+    // Adam7 passes: first column, first row, column step and row step; an
+    // image that is not interlaced is the single pass {0, 0, 1, 1}
+    const int ADAM7[7][4] = {
+        {0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4},
+        {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}
+    };
+    const int NO_INTERLACE[1][4] = {{0, 0, 1, 1}};
+
+    inline unsigned long png_u32(const unsigned char* p) {
+        return (unsigned long)p[0] << 24 | (unsigned long)p[1] << 16 | (unsigned long)p[2] << 8 | p[3];
+    }
+
+    inline void put_png_u32(unsigned char* p, unsigned long v) {
+        p[0] = (unsigned char)(v >> 24);
+        p[1] = (unsigned char)(v >> 16);
+        p[2] = (unsigned char)(v >> 8);
+        p[3] = (unsigned char)v;
+    }
+
+    // a, b, c are the bytes left, above and above-left
+    inline unsigned char paeth(int a, int b, int c) {
+        int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+        return (unsigned char)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+    }
+
+    // a zlib stream that is ended however the function using it returns
+    struct ZStream {
+        z_stream z;
+        bool inflating, open;
+
+        explicit ZStream(bool inflating) : inflating(inflating), open(false) {
+            memset(&z, 0, sizeof(z));
+        }
+
+        ~ZStream() {
+            if (open) {
+                if (inflating) inflateEnd(&z);
+                else deflateEnd(&z);
+            }
+        }
+    };
+
+    //
+    // filters
+    //
+
+    // undoes the filter of a row of n bytes in place, given the row above it
+    // (already unfiltered; zeros above the first row) and bytes per pixel
+    bool unfilter_row(int type, unsigned char* row, const unsigned char* prev, unsigned long n, int bpp) {
+        unsigned long i;
+        switch (type) {
+        case PNG_NONE:
+            break;
+        case PNG_SUB:
+            for (i=bpp; i<n; i++) row[i] = (unsigned char)(row[i] + row[i-bpp]);
+            break;
+        case PNG_UP:
+            for (i=0; i<n; i++) row[i] = (unsigned char)(row[i] + prev[i]);
+            break;
+        case PNG_AVERAGE:
+            for (i=0; i<(unsigned long)bpp && i<n; i++) row[i] = (unsigned char)(row[i] + (prev[i] >> 1));
+            for (; i<n; i++) row[i] = (unsigned char)(row[i] + ((row[i-bpp] + prev[i]) >> 1));
+            break;
+        case PNG_PAETH:
+            for (i=0; i<(unsigned long)bpp && i<n; i++) row[i] = (unsigned char)(row[i] + prev[i]);
+            for (; i<n; i++) row[i] = (unsigned char)(row[i] + paeth(row[i-bpp], prev[i], prev[i-bpp]));
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    // filters a row of n bytes into out (the filter type byte, then n bytes);
+    // returns the sum of the filtered bytes as signed values
+    unsigned long filter_row(int type, const unsigned char* row, const unsigned char* prev,
+                             unsigned long n, int bpp, unsigned char* out) {
+        out[0] = (unsigned char)type;
+        unsigned char* f = out + 1;
+        unsigned long i;
+        switch (type) {
+        case PNG_NONE:
+            memcpy(f, row, n);
+            break;
+        case PNG_SUB:
+            for (i=0; i<(unsigned long)bpp && i<n; i++) f[i] = row[i];
+            for (; i<n; i++) f[i] = (unsigned char)(row[i] - row[i-bpp]);
+            break;
+        case PNG_UP:
+            for (i=0; i<n; i++) f[i] = (unsigned char)(row[i] - prev[i]);
+            break;
+        case PNG_AVERAGE:
+            for (i=0; i<(unsigned long)bpp && i<n; i++) f[i] = (unsigned char)(row[i] - (prev[i] >> 1));
+            for (; i<n; i++) f[i] = (unsigned char)(row[i] - ((row[i-bpp] + prev[i]) >> 1));
+            break;
+        case PNG_PAETH:
+            for (i=0; i<(unsigned long)bpp && i<n; i++) f[i] = (unsigned char)(row[i] - prev[i]);
+            for (; i<n; i++) f[i] = (unsigned char)(row[i] - paeth(row[i-bpp], prev[i], prev[i-bpp]));
+            break;
+        }
+        unsigned long sum = 0;
+        for (i=0; i<n; i++) sum += (unsigned long)abs((signed char)f[i]);
+        return sum;
+    }
+
+    //
+    // reading
+    //
+
+    // IHDR, palette and transparency of a PNG being read
+    struct PngInfo {
+        int width, height, depth, color, interlace;
+        int samples;                            // samples per pixel in the file
+        std::vector<unsigned char> palette;     // R,G,B,A per entry
+        bool has_key;                           // tRNS color of gray/RGB images
+        unsigned int key[3];
+    };
+
+    // widens one unfiltered row of a 16-bit pass to 16-bit R,G,B(,A), writing
+    // pixel i at out + i*step
+    void expand_row16(const PngInfo& info, const unsigned char* row, int n, unsigned char* out,
+                      long step, int channels) {
+        for (int i=0; i<n; i++, out += step) {
+            const unsigned char* s = row + 2*info.samples*i;
+            switch (info.color) {
+            case 6:
+                memcpy(out, s, 8);
+                break;
+            case 0:
+            case 4:
+                for (int c=0; c<3; c++) memcpy(out + 2*c, s, 2);
+                if (info.color == 4) memcpy(out + 6, s + 2, 2);
+                break;
+            case 2:
+                memcpy(out, s, 6);
+                break;
+            }
+            if (channels == 4 && (info.color == 0 || info.color == 2)) {
+                bool clear = info.has_key;
+                for (int c=0; c<(info.color == 2 ? 3 : 1) && clear; c++)
+                    clear = (unsigned int)(s[2*c] << 8 | s[2*c+1]) == info.key[c];
+                out[6] = out[7] = clear ? 0 : 255;
+            }
+        }
+    }
+
+    // widens one unfiltered row of a pass to 8-bit R,G,B(,A), writing pixel i
+    // at out + i*step; false on a palette index past the end of the palette
+    bool expand_row(const PngInfo& info, const unsigned char* row, int n, unsigned char* out,
+                    long step, int channels) {
+        int depth = info.depth;
+        if (depth == 16) {
+            expand_row16(info, row, n, out, step, channels);
+            return true;
+        }
+        unsigned int max = (1u << depth) - 1;
+        for (int i=0; i<n; i++, out += step) {
+            switch (info.color) {
+            case 2:
+                out[0] = row[3*i];
+                out[1] = row[3*i+1];
+                out[2] = row[3*i+2];
+                if (channels == 4)
+                    out[3] = info.has_key && row[3*i] == info.key[0] && row[3*i+1] == info.key[1] &&
+                             row[3*i+2] == info.key[2] ? 0 : 255;
+                break;
+            case 6:
+                memcpy(out, row + 4*i, 4);
+                break;
+            case 4:
+                out[0] = out[1] = out[2] = row[2*i];
+                out[3] = row[2*i+1];
+                break;
+            default: {
+                unsigned int v = depth == 8 ? row[i]
+                               : (row[(i*depth) >> 3] >> (8 - depth - ((i*depth) & 7))) & max;
+                if (info.color == 3) {
+                    if (4*v >= info.palette.size()) return false;
+                    memcpy(out, &info.palette[4*v], channels);
+                } else {
+                    out[0] = out[1] = out[2] = (unsigned char)(v * 255 / max);
+                    if (channels == 4) out[3] = info.has_key && v == info.key[0] ? 0 : 255;
+                }
+            }
+            }
+        }
+        return true;
+    }
+
+    bool read_png(std::string path, PngImage& image) {
+        std::ifstream ifs(path.c_str(), std::ios::binary|std::ios::in);
+        unsigned char sig[8];
+        if (!ifs.read((char*)sig, 8) || memcmp(sig, PNG_SIGNATURE, 8) != 0) return false;
+        if (!ifs.seekg(0, std::ios::end)) return false;
+        std::vector<unsigned char> file((size_t)ifs.tellg() - 8);
+        if (!ifs.seekg(8) || (!file.empty() && !ifs.read((char*)&file[0], (std::streamsize)file.size())))
+            return false;
+
+        //
+        // chunks: IHDR first, PLTE and tRNS before the image data, which may
+        // be split over any number of IDATs
+        //
+
+        PngInfo info;
+        info.has_key = false;
+        std::vector<const unsigned char*> idat;
+        std::vector<unsigned long> idat_bytes;
+        bool header = false;
+        for (unsigned long at=0; ; ) {
+            if (file.size() - at < 12) return false;
+            unsigned long n = png_u32(&file[at]);
+            if (n > file.size() - at - 12) return false;
+            const unsigned char* type = &file[at+4];
+            const unsigned char* data = type + 4;
+            if (png_u32(data + n) != crc32(crc32(0, NULL, 0), type, (uInt)(n + 4))) return false;
+            at += 12 + n;
+
+            if (memcmp(type, "IHDR", 4) == 0) {
+                if (n != 13) return false;
+                info.width = (int)png_u32(data);
+                info.height = (int)png_u32(data + 4);
+                info.depth = data[8];
+                info.color = data[9];
+                info.interlace = data[12];
+                if (info.width <= 0 || info.height <= 0 || data[10] != 0 || data[11] != 0 || info.interlace > 1)
+                    return false;
+                // palettes go up to 8 bits, gray to 16, the rest are 8 or 16
+                bool valid = info.depth == 8 || info.depth == 16;
+                switch (info.color) {
+                case 0: info.samples = 1; valid = valid || info.depth == 1 || info.depth == 2 || info.depth == 4; break;
+                case 3: info.samples = 1; valid = info.depth == 1 || info.depth == 2 || info.depth == 4 || info.depth == 8; break;
+                case 2: info.samples = 3; break;
+                case 4: info.samples = 2; break;
+                case 6: info.samples = 4; break;
+                default: return false;
+                }
+                if (!valid) return false;
+                header = true;
+            } else if (!header) {
+                return false;
+            } else if (memcmp(type, "PLTE", 4) == 0) {
+                if (n % 3 != 0 || n > 3*256) return false;
+                info.palette.assign(n / 3 * 4, 255);
+                for (unsigned long i=0; i<n/3; i++) memcpy(&info.palette[4*i], data + 3*i, 3);
+            } else if (memcmp(type, "tRNS", 4) == 0) {
+                if (info.color == 3) {
+                    for (unsigned long i=0; i<n && 4*i<info.palette.size(); i++) info.palette[4*i+3] = data[i];
+                } else if (info.color == 0 && n >= 2) {
+                    info.key[0] = png_u32(data) >> 16;
+                    info.has_key = true;
+                } else if (info.color == 2 && n >= 6) {
+                    for (int c=0; c<3; c++) info.key[c] = (unsigned int)(data[2*c] << 8 | data[2*c+1]);
+                    info.has_key = true;
+                }
+            } else if (memcmp(type, "IDAT", 4) == 0) {
+                idat.push_back(data);
+                idat_bytes.push_back(n);
+            } else if (memcmp(type, "IEND", 4) == 0) {
+                break;
+            } else if (!(type[0] & 0x20)) {
+                // an unknown critical chunk
+                return false;
+            }
+        }
+        if (!header || idat.empty() || (info.color == 3 && info.palette.empty())) return false;
+
+        // alpha is kept whenever the image has any
+        bool alpha = info.color == 4 || info.color == 6 || info.has_key;
+        for (unsigned long i=3; i<info.palette.size() && !alpha; i+=4) alpha = info.palette[i] != 255;
+        int channels = alpha ? 4 : 3;
+        int bps = info.depth == 16 ? 2 : 1;
+        unsigned long long pixels = (unsigned long long)info.width * info.height;
+        if (pixels > (1ULL << 32)) return false;
+        image.width = info.width;
+        image.height = info.height;
+        image.channels = channels;
+        image.depth = 8 * bps;
+        image.pixels.resize((size_t)(pixels * channels * bps));
+
+        //
+        // inflate and unfilter a row at a time, pass by pass
+        //
+
+        ZStream zs(true);
+        if (inflateInit(&zs.z) != Z_OK) return false;
+        zs.open = true;
+        unsigned long next_idat = 0;
+        int bits = info.samples * info.depth;
+        int bpp = std::max(bits / 8, 1);
+        const int (*passes)[4] = info.interlace ? ADAM7 : NO_INTERLACE;
+        int pass_count = info.interlace ? 7 : 1;
+        std::vector<unsigned char> cur, prev;
+        for (int p=0; p<pass_count; p++) {
+            const int* pass = passes[p];
+            if (info.width <= pass[0] || info.height <= pass[1]) continue;
+            int w = (info.width - pass[0] + pass[2] - 1) / pass[2];
+            int h = (info.height - pass[1] + pass[3] - 1) / pass[3];
+            unsigned long row_bytes = ((unsigned long)w * bits + 7) / 8;
+            cur.assign(row_bytes + 1, 0);
+            prev.assign(row_bytes + 1, 0);
+            for (int y=0; y<h; y++) {
+                zs.z.next_out = &cur[0];
+                zs.z.avail_out = (uInt)(row_bytes + 1);
+                while (zs.z.avail_out > 0) {
+                    if (zs.z.avail_in == 0) {
+                        if (next_idat == idat.size()) return false;
+                        zs.z.next_in = (Bytef*)idat[next_idat];
+                        zs.z.avail_in = (uInt)idat_bytes[next_idat];
+                        next_idat++;
+                        continue;
+                    }
+                    int ret = inflate(&zs.z, Z_NO_FLUSH);
+                    if (ret == Z_STREAM_END && zs.z.avail_out > 0) return false;
+                    if (ret != Z_OK && ret != Z_STREAM_END) return false;
+                }
+                if (!unfilter_row(cur[0], &cur[1], &prev[1], row_bytes, bpp)) return false;
+                size_t first = ((size_t)(pass[1] + y*pass[3]) * info.width + pass[0]) * channels * bps;
+                if (!expand_row(info, &cur[1], w, &image.pixels[first], (long)pass[2] * channels * bps, channels))
+                    return false;
+                cur.swap(prev);
+            }
+        }
+        return true;
+    }
+
+    //
+    // writing
+    //
+
+    // writes one chunk of n bytes of data
+    bool write_chunk(std::ofstream& ofs, const char* type, const unsigned char* data, unsigned long n) {
+        unsigned char head[8], tail[4];
+        put_png_u32(head, n);
+        memcpy(head + 4, type, 4);
+        unsigned long crc = crc32(crc32(0, NULL, 0), head + 4, 4);
+        if (n > 0) crc = crc32(crc, data, (uInt)n);
+        put_png_u32(tail, crc);
+        ofs.write((const char*)head, 8);
+        if (n > 0) ofs.write((const char*)data, (std::streamsize)n);
+        ofs.write((const char*)tail, 4);
+        return !ofs.fail();
+    }
+
+    bool write_png(std::string path, const PngImage& image, const PngOptions& options) {
+        if (image.width <= 0 || image.height <= 0 || (image.channels != 3 && image.channels != 4) ||
+            (image.depth != 8 && image.depth != 16) || options.level < 0 || options.level > 9 ||
+            options.filter < PNG_NONE || options.filter > PNG_ADAPTIVE)
+            return false;
+        int bpp = image.channels * image.depth / 8;
+        unsigned long row_bytes = (unsigned long)image.width * bpp;
+        if (image.pixels.size() < (size_t)row_bytes * image.height) return false;
+
+        std::ofstream ofs(path.c_str(), std::ios::binary|std::ios::out|std::ios::trunc);
+        if (!ofs) return false;
+        ofs.write((const char*)PNG_SIGNATURE, 8);
+        unsigned char ihdr[13];
+        put_png_u32(ihdr, (unsigned long)image.width);
+        put_png_u32(ihdr + 4, (unsigned long)image.height);
+        ihdr[8] = (unsigned char)image.depth;
+        ihdr[9] = image.channels == 4 ? 6 : 2;
+        ihdr[10] = ihdr[11] = ihdr[12] = 0;
+        if (!write_chunk(ofs, "IHDR", ihdr, 13)) return false;
+
+        // filtered rows compress best with zlib's filtered strategy
+        ZStream zs(false);
+        if (deflateInit2(&zs.z, options.level, Z_DEFLATED, 15, 8,
+                         options.filter == PNG_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED) != Z_OK)
+            return false;
+        zs.open = true;
+
+        // each row is filtered (all five ways when adapting), then deflated;
+        // full output buffers go out as IDAT chunks
+        std::vector<unsigned char> zeros(row_bytes, 0), out(PNG_CHUNK_SIZE);
+        std::vector<unsigned char> filtered((row_bytes + 1) * (options.filter == PNG_ADAPTIVE ? 5 : 1));
+        zs.z.next_out = &out[0];
+        zs.z.avail_out = (uInt)out.size();
+        for (int y=0; y<=image.height; y++) {
+            bool last = y == image.height;
+            if (!last) {
+                const unsigned char* row = &image.pixels[(size_t)row_bytes * y];
+                const unsigned char* prev = y > 0 ? row - row_bytes : &zeros[0];
+                unsigned char* best = &filtered[0];
+                if (options.filter == PNG_ADAPTIVE) {
+                    unsigned long least = 0;
+                    for (int type=PNG_NONE; type<=PNG_PAETH; type++) {
+                        unsigned char* f = &filtered[(row_bytes + 1) * type];
+                        unsigned long sum = filter_row(type, row, prev, row_bytes, bpp, f);
+                        if (type == PNG_NONE || sum < least) {
+                            least = sum;
+                            best = f;
+                        }
+                    }
+                } else {
+                    filter_row(options.filter, row, prev, row_bytes, bpp, best);
+                }
+                zs.z.next_in = best;
+                zs.z.avail_in = (uInt)(row_bytes + 1);
+            }
+            for (;;) {
+                int ret = deflate(&zs.z, last ? Z_FINISH : Z_NO_FLUSH);
+                if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) return false;
+                bool full = zs.z.avail_out == 0;
+                if (full || ret == Z_STREAM_END) {
+                    if (!write_chunk(ofs, "IDAT", &out[0], out.size() - zs.z.avail_out)) return false;
+                    zs.z.next_out = &out[0];
+                    zs.z.avail_out = (uInt)out.size();
+                }
+                if (ret == Z_STREAM_END || (!last && zs.z.avail_in == 0 && !full)) break;
+            }
+        }
+        if (!write_chunk(ofs, "IEND", NULL, 0)) return false;
+        ofs.close();
+        return !ofs.fail();
+    }
+
+    void to_rgb8(PngImage& image) {
+        int bps = image.depth / 8;
+        if (image.channels == 3 && bps == 1) return;
+        unsigned long long pixels = (unsigned long long)image.width * image.height;
+        unsigned char* out = image.pixels.empty() ? NULL : &image.pixels[0];
+        const unsigned char* in = out;
+        // the output never overtakes the input, so this works in place
+        for (unsigned long long i=0; i<pixels; i++, in += image.channels * bps, out += 3) {
+            out[0] = in[0];
+            out[1] = in[bps];
+            out[2] = in[2*bps];
+        }
+        image.pixels.resize((size_t)(pixels * 3));
+        image.channels = 3;
+        image.depth = 8;
+    }
+
+    //
+    // names
+    //
+
+    bool png_name(std::string path) {
+        if (path.size() < 4) return false;
+        std::string ext = path.substr(path.size() - 4);
+        for (unsigned long i=0; i<ext.size(); i++) ext[i] = (char)tolower((unsigned char)ext[i]);
+        return ext == ".png";
+    }
+
+    bool parse_png_filter(std::string name, PngFilter& filter) {
+        static const char* names[] = {"none", "sub", "up", "average", "paeth", "adaptive"};
+        for (int i=PNG_NONE; i<=PNG_ADAPTIVE; i++) {
+            if (name == names[i] || (i == PNG_AVERAGE && name == "avg")) {
+                filter = (PngFilter)i;
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoPng.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: in-process PNG carrier codec.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOPNG_H_
+#define _STEGOPNG_H_
+
+#include <string>
+#include <vector>
+
+namespace f2i_stego_tools {
+
+    // PNG row filters, numbered as in the PNG spec; PNG_ADAPTIVE picks the
+    // one per row whose output looks smallest (least sum of absolute values)
+    enum PngFilter {
+        PNG_NONE,
+        PNG_SUB,
+        PNG_UP,
+        PNG_AVERAGE,
+        PNG_PAETH,
+        PNG_ADAPTIVE
+    };
+
+    // how PNG images are written: zlib level 0 (stored, fastest) .. 9
+    // (smallest) and the row filter
+    struct PngOptions {
+        PngOptions() : level(6), filter(PNG_ADAPTIVE) {}
+
+        int level;
+        PngFilter filter;
+    };
+
+    // an image decoded into memory as R,G,B or R,G,B,A rows, top row first
+    // and without padding; 16-bit samples are stored big-endian, as in the file
+    struct PngImage {
+        PngImage() : width(0), height(0), channels(3), depth(8) {}
+
+        std::vector<unsigned char> pixels;
+        int width, height;
+        int channels;       // 3 or 4
+        int depth;          // bits per sample, 8 or 16
+    };
+
+    // decodes a PNG of any color type and bit depth, interlaced or not;
+    // grayscale is widened to R,G,B, palettes are looked up and transparency
+    // (tRNS) becomes an alpha channel. 16-bit samples stay 16-bit, anything
+    // smaller becomes 8-bit. False if the file is not a PNG or is corrupt
+    bool read_png(std::string path, PngImage& image);
+
+    // encodes an image as a non-interlaced RGB or RGBA PNG of its depth
+    bool write_png(std::string path, const PngImage& image, const PngOptions& options=PngOptions());
+
+    // narrows an image to 8-bit R,G,B in place: alpha is dropped and 16-bit
+    // samples keep their most significant byte
+    void to_rgb8(PngImage& image);
+
+    // whether a file name ends in ".png" (any case)
+    bool png_name(std::string path);
+
+    // parses a filter name: none, sub, up, average (or avg), paeth or adaptive
+    bool parse_png_filter(std::string name, PngFilter& filter);
+}
+
+#endif   // !defined _STEGOPNG_H_
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoWorkers.cpp
+//  Date:           10/17/2026
+//  Description:    Main implementation for Stenography: persistent worker threads.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "StegoWorkers.h"
+
+namespace f2i_stego_tools {
+
+    Workers::Workers()
+        : fn(NULL), task(NULL), tasks(0), next(0), left(0), stop(false), grown(0) {
+    }
+
+    Workers::~Workers() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (int i=0; i<(int)threads.size(); i++) threads[i].join();
+    }
+
+    void Workers::run(int n, void (*f)(void*, int), void* t) {
+        std::unique_lock<std::mutex> lock(m);
+
+        // start whatever threads this job needs beyond the caller
+        if ((int)threads.size() < n-1) {
+            if ((int)threads.capacity() < n-1) {
+                threads.reserve(n-1);
+                grown++;
+            }
+            while ((int)threads.size() < n-1) {
+                threads.push_back(std::thread(&Workers::loop, this));
+                grown++;
+            }
+        }
+
+        // post the job
+        fn = f;
+        task = t;
+        tasks = n;
+        next = 0;
+        left = n;
+        wake.notify_all();
+
+        // the calling thread claims tasks as well, then waits for the rest
+        while (next < tasks) {
+            int k = next++;
+            lock.unlock();
+            fn(task, k);
+            lock.lock();
+            left--;
+        }
+        idle.wait(lock, [this]() { return left == 0; });
+    }
+
+    void Workers::loop() {
+        std::unique_lock<std::mutex> lock(m);
+        for (;;) {
+            wake.wait(lock, [this]() { return stop || next < tasks; });
+            if (stop) return;
+            int k = next++;
+            lock.unlock();
+            fn(task, k);
+            lock.lock();
+            if (--left == 0) idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Author:         Ibrahim Sardar
+//  Class:          CSCI 557
+//  Filename:       StegoWorkers.h
+//  Date:           10/17/2026
+//  Description:    Header for Stenography: persistent worker threads.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Honor Pledge:
+//
+//  I pledge that I have neither given nor received any help on this project.
+//
+//  ibsardar
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2018 Copyright Holder All Rights Reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _STEGOWORKERS_H_
+#define _STEGOWORKERS_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace f2i_stego_tools {
+
+    // threads that stay alive between jobs, so embedding and extracting in
+    // bands does not start (and allocate) new threads for every block
+    class Workers {
+    public:
+        Workers();
+
+        // stops and joins the threads
+        ~Workers();
+
+        // runs task(0) .. task(tasks-1) concurrently, one of them on the
+        // calling thread, and returns once all of them have finished; threads
+        // are only started when a job needs more than the pool has
+        template<class F>
+        void run(int tasks, F& task) {
+            if (tasks == 1) task(0);
+            else if (tasks > 1) run(tasks, &call<F>, &task);
+        }
+
+        // number of heap allocations made so far (thread starts and growth
+        // of the thread list)
+        unsigned long long allocations() const { return grown; }
+
+    private:
+        // not copyable
+        Workers(const Workers&);
+        Workers& operator=(const Workers&);
+
+        template<class F>
+        static void call(void* task, int k) { (*(F*)task)(k); }
+
+        void run(int tasks, void (*fn)(void*, int), void* task);
+        void loop();
+
+        std::vector<std::thread> threads;
+        std::mutex m;
+        std::condition_variable wake;   // a job was posted or the pool stops
+        std::condition_variable idle;   // the last task of a job finished
+        void (*fn)(void*, int);         // current job
+        void* task;
+        int tasks, next, left;          // tasks in the job, next to claim, not finished
+        bool stop;
+        unsigned long long grown;
+    };
+
+    // runs task(0..n-1) on up to this many threads (0 = one per hardware
+    // thread), each thread claiming the next index when it is done
+    template<class F>
+    void parallel_for(int n, int threads, F task) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+        if (threads > n) threads = n;
+        std::atomic<int> next(0);
+        auto worker = [&](int) {
+            for (int i; (i = next++) < n; ) task(i);
+        };
+        Workers workers;
+        workers.run(threads, worker);
+    }
+}
+
+#endif   // !defined _STEGOWORKERS_H_
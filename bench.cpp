@@ -0,0 +1,259 @@
+#include "File2ImageStegoTools.h"
+#include "StegoKernels.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define STEGO_RUSAGE 1
+    #include <sys/resource.h>
+#endif
+
+// usage:
+//   bench [--quick] [--reps N] [--threads N] [--level N] [--key] [--seed N] [--fill F]
+//   bench --kernels [--bytes N]
+//
+// encrypts and decrypts random payloads into synthetic (random noise)
+// carriers from 256x256 up to 8K for every lsbs 1..7, all in memory, and
+// prints one JSON document on stdout (progress goes to stderr):
+//   --quick      stop at 1920x1080
+//   --reps N     timed runs per case after one untimed warm-up (default 7)
+//   --threads N  embed/extract threads (default 0 = one per hardware thread)
+//   --level N    deflate the payload first at level 1..9 (default 0 = off)
+//   --key        key the payload with a ChaCha20 keystream
+//   --seed N     seed of the carriers, payloads and key (default 1)
+//   --fill F     payload size as a fraction of what the carrier holds (default 0.9)
+// the same seed and options give the same carriers and payloads, so runs of
+// different builds and machines can be compared case by case
+//   --kernels    instead, time the embed/extract kernels alone: every kernel set
+//                the CPU supports at every lsbs 1..8, over an in-cache buffer of
+//                --bytes N carrier bytes (default 1 MiB), best of several rounds
+
+namespace {
+
+    // a synthetic carrier size
+    struct Carrier {
+        const char* name;
+        int width, height;
+    };
+
+    const Carrier CARRIERS[] = {
+        {"256x256",   256,  256},
+        {"512x512",   512,  512},
+        {"1024x1024", 1024, 1024},
+        {"1080p",     1920, 1080},
+        {"4K",        3840, 2160},
+        {"8K",        7680, 4320},
+    };
+    const int QUICK_CARRIERS = 4;
+
+    // fills a buffer with random bytes
+    void randomize(std::vector<unsigned char>& buf, std::mt19937_64& rng) {
+        unsigned long i = 0;
+        for (; i + 8 <= buf.size(); i += 8) {
+            unsigned long long v = rng();
+            memcpy(&buf[i], &v, 8);
+        }
+        for (; i < buf.size(); i++) buf[i] = (unsigned char)rng();
+    }
+
+    // latencies of one operation over the timed runs
+    struct Timing {
+        std::vector<double> seconds;
+
+        // nearest-rank percentile, p in 0..100
+        double percentile(double p) const {
+            std::vector<double> s(seconds);
+            std::sort(s.begin(), s.end());
+            int rank = (int)(p / 100 * s.size() + 0.999999);
+            return s[std::min(std::max(rank, 1), (int)s.size()) - 1];
+        }
+
+        std::string json(unsigned long long bytes) const {
+            double p50 = percentile(50);
+            std::stringstream ss;
+            ss.precision(6);
+            ss << "{\"mb_per_s\":" << (p50 > 0 ? bytes / p50 / 1e6 : 0)
+               << ",\"min_ms\":" << percentile(0) * 1e3 << ",\"p50_ms\":" << p50 * 1e3
+               << ",\"p90_ms\":" << percentile(90) * 1e3 << ",\"p99_ms\":" << percentile(99) * 1e3
+               << ",\"max_ms\":" << percentile(100) * 1e3 << "}";
+            return ss.str();
+        }
+    };
+
+    // starts a new peak: on Linux the peak resident set size can be reset
+    // through clear_refs, elsewhere it only ever grows over the process
+    void reset_peak_rss() {
+        std::ofstream ofs("/proc/self/clear_refs");
+        if (ofs) ofs << "5" << std::flush;
+    }
+
+    // peak resident set size in KiB since the last reset_peak_rss() (or the
+    // start of the process), 0 if it cannot be read
+    long long peak_rss_kb() {
+        std::ifstream ifs("/proc/self/status");
+        std::string line;
+        while (std::getline(ifs, line))
+            if (line.compare(0, 6, "VmHWM:") == 0) return atoll(line.c_str() + 6);
+    #ifdef STEGO_RUSAGE
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        #ifdef __APPLE__
+            return ru.ru_maxrss / 1024;
+        #else
+            return ru.ru_maxrss;
+        #endif
+        }
+    #endif
+        return 0;
+    }
+
+    double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // bench --kernels: carrier MB/s of each kernel set at each lsbs
+    int run_kernel_bench(unsigned long bytes) {
+        std::vector<f2i_stego_tools::Kernels> all = f2i_stego_tools::supported_kernels();
+        std::cout << "{\"bench\":\"kernels\",\"best\":\"" << f2i_stego_tools::best_kernels().name
+                  << "\",\"bytes\":" << bytes << ",\"results\":[";
+        bool first = true;
+        for (unsigned long k=0; k<all.size(); k++) {
+            for (int lsbs=1; lsbs<=8; lsbs++) {
+                std::cerr << all[k].name << " lsbs " << lsbs << "..." << std::endl;
+                double embed_bps, extract_bps;
+                f2i_stego_tools::bench_kernels(all[k], lsbs, bytes, embed_bps, extract_bps);
+                std::cout << (first ? "" : ",") << "\n{\"kernels\":\"" << all[k].name << "\",\"lsbs\":" << lsbs
+                          << ",\"embed\":{\"mb_per_s\":" << embed_bps / 1e6 << "}"
+                          << ",\"extract\":{\"mb_per_s\":" << extract_bps / 1e6 << "}}";
+                first = false;
+            }
+        }
+        std::cout << "\n]}" << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    // options
+    bool quick = false, keyed = false, kernels = false;
+    int reps = 7, threads = 0, level = 0;
+    unsigned long kernel_bytes = 1UL << 20;
+    unsigned long long seed = 1;
+    double fill = 0.9;
+    for (int i=1; i<argc; i++) {
+        std::string opt = argv[i];
+        bool has_value = i + 1 < argc;
+        if (opt == "--quick") quick = true;
+        else if (opt == "--key") keyed = true;
+        else if (opt == "--kernels") kernels = true;
+        else if (opt == "--bytes" && has_value) kernel_bytes = strtoul(argv[++i], NULL, 10);
+        else if (opt == "--reps" && has_value) reps = atoi(argv[++i]);
+        else if (opt == "--threads" && has_value) threads = atoi(argv[++i]);
+        else if (opt == "--level" && has_value) level = atoi(argv[++i]);
+        else if (opt == "--seed" && has_value) seed = strtoull(argv[++i], NULL, 10);
+        else if (opt == "--fill" && has_value) fill = atof(argv[++i]);
+        else {
+            std::cerr << "ERROR: Unknown option \"" << opt << "\"." << std::endl;
+            return 2;
+        }
+    }
+    if (reps < 1 || fill <= 0 || fill > 1 || level < 0 || level > 9) {
+        std::cerr << "ERROR: Need --reps >= 1, 0 < --fill <= 1 and --level 0..9." << std::endl;
+        return 2;
+    }
+    if (kernels) {
+        if (kernel_bytes < 1) {
+            std::cerr << "ERROR: Need --bytes >= 1." << std::endl;
+            return 2;
+        }
+        return run_kernel_bench(kernel_bytes);
+    }
+
+    std::mt19937_64 rng(seed);
+    unsigned char key[f2i_stego_tools::KEY_BYTES];
+    for (int i=0; i<f2i_stego_tools::KEY_BYTES; i++) key[i] = (unsigned char)rng();
+
+    f2i_stego_tools::Encoder encoder(1, threads, level);
+    f2i_stego_tools::Decoder decoder(threads);
+    if (keyed) {
+        encoder.set_key(key);
+        decoder.set_key(key);
+    }
+
+    std::cout << "{\"bench\":\"f2i_stego_tools\",\"kernels\":\"" << f2i_stego_tools::best_kernels().name
+              << "\",\"threads\":" << threads << ",\"level\":" << level
+              << ",\"keyed\":" << (keyed ? "true" : "false") << ",\"seed\":" << seed
+              << ",\"reps\":" << reps << ",\"fill\":" << fill << ",\"results\":[";
+
+    int carriers = quick ? QUICK_CARRIERS : (int)(sizeof(CARRIERS) / sizeof(CARRIERS[0]));
+    bool first = true, failed = false;
+    std::vector<unsigned char> rgb, payload, out;
+    for (int c=0; c<carriers; c++) {
+        const Carrier& carrier = CARRIERS[c];
+        rgb.resize(3ULL * carrier.width * carrier.height);
+        randomize(rgb, rng);
+        f2i_stego_tools::RGBView view(&rgb[0], carrier.width, carrier.height, 1, 3, 3L * carrier.width);
+
+        for (int lsbs=1; lsbs<=7; lsbs++) {
+            std::cerr << carrier.name << " lsbs " << lsbs << "..." << std::endl;
+
+            // what the carrier holds, less room for the longest header
+            const unsigned long long HEADER_ROOM = 512;
+            payload.resize((unsigned long long)((view.size() * lsbs / 8 - HEADER_ROOM) * fill));
+            randomize(payload, rng);
+            encoder.set_lsbs(lsbs);
+            reset_peak_rss();
+
+            // one untimed run grows the buffers, then the timed ones
+            Timing enc, dec;
+            f2i_stego_tools::Result r;
+            for (int rep=-1; rep<reps && !failed; rep++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                r = encoder.encrypt(view, &payload[0], payload.size(), "dat");
+                double e = seconds_since(start);
+                if (r.status != f2i_stego_tools::SUCCESS) {
+                    failed = true;
+                    break;
+                }
+                start = std::chrono::steady_clock::now();
+                r = decoder.decrypt(view, out);
+                double d = seconds_since(start);
+                if (r.status != f2i_stego_tools::SUCCESS || out != payload) {
+                    failed = true;
+                    break;
+                }
+                if (rep >= 0) {
+                    enc.seconds.push_back(e);
+                    dec.seconds.push_back(d);
+                }
+            }
+            if (failed) {
+                std::cerr << "ERROR: " << carrier.name << " lsbs " << lsbs << ": "
+                          << (r.message.empty() ? "Decrypted data does not match." : r.message) << std::endl;
+                break;
+            }
+
+            std::cout << (first ? "" : ",") << "\n{\"carrier\":\"" << carrier.name
+                      << "\",\"width\":" << carrier.width << ",\"height\":" << carrier.height
+                      << ",\"lsbs\":" << lsbs << ",\"payload_bytes\":" << payload.size()
+                      << ",\"image_bytes\":" << r.stats.image_bytes
+                      << ",\"encrypt\":" << enc.json(payload.size())
+                      << ",\"decrypt\":" << dec.json(payload.size())
+                      << ",\"peak_rss_kb\":" << peak_rss_kb() << "}";
+            first = false;
+        }
+        if (failed) break;
+    }
+    std::cout << "\n]}" << std::endl;
+    return failed ? 1 : 0;
+}
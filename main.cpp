@@ -1,21 +1,252 @@
-#include "File2ImageStegoTools.h"
-
-#include <string>
-
-int main() {
-
-    std::string img_filename = "tiger.bmp";
-    std::string file_filename = "LAA.exe";
-    int least_significant_bits = 7; // must be between 1 and 7, inclusive
-
-    // encrypt file data into image data
-    f2i_stego_tools::encrypt(img_filename, file_filename, least_significant_bits);
-
-    // decrypt image and save both the image and data file
-    f2i_stego_tools::decrypt("encrypted.bmp");
-
-    return 0;
-}
-
-
-
+#include "File2ImageStegoTools.h"
+#include "StegoBatch.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+
+// printed to stderr for arguments no mode accepts
+const char* const USAGE =
+    "usage:\n"
+    "  main                               encrypt LAA.exe into tiger.bmp and decrypt it again\n"
+    "  main encrypt <image> <file> [lsbs] [level] [keyfile]\n"
+    "                                     encrypt into encrypted.bmp, deflating first at level 1..9\n"
+    "                                     and keying with a 32 byte key file\n"
+    "  main decrypt <image> [keyfile]     decrypt into decrypted.<extension>\n"
+    "  main extract <image> <offset> <length> [keyfile]\n"
+    "                                     write that byte range of the hidden file to stdout\n"
+    "  main verify <image>...             check each image's data against its checksum\n"
+    "  main scan <file or directory>...   list the images carrying data (reads\n"
+    "                                     only the header of 24-bit BMPs, decodes other images)\n"
+    "  main capacity <image> [lsbs]       bytes of data the image can hold when saved by encrypt\n"
+    "  main fits <image> <file> [lsbs]    exit status 0 if the file fits, 1 if not\n"
+    "  main batch <manifest> [threads]    encrypt every job listed in a manifest\n"
+    "  main split <file> <lsbs> <image>... spread a file over several images\n"
+    "  main join <image>...               put a split file back together\n"
+    "  main --json <mode> ...             any of the above, also printing each result and its\n"
+    "                                     per-phase times and counters as a line of JSON on stderr\n"
+    "                                     (the exit status is 0 only if every result is SUCCESS)\n"
+    "  main --png [--png-level N] [--png-filter none|sub|up|avg|paeth|adaptive] <mode> ...\n"
+    "                                     encrypt/split save PNGs (encrypted.png, ...) written in-process\n"
+    "                                     at zlib level 0..9 (default 6) with that row filter\n"
+    "                                     (default adaptive); either option implies --png, and\n"
+    "                                     batch uses them for its outputs named .png; capacity/fits\n"
+    "                                     then count the alpha channel and 16-bit samples a PNG keeps\n"
+    "  lsbs is 1..7, or up to 8 for 16-bit PNG carriers; PNG carriers saved with --png keep\n"
+    "  their alpha channel and 16-bit samples and carry data in them too\n";
+
+int main(int argc, char** argv) {
+
+    // the demo runs only without any arguments
+    bool demo = argc == 1;
+
+    // options before the mode
+    bool json = false, png = false;
+    f2i_stego_tools::PngOptions png_options;
+    while (argc > 1 && std::string(argv[1]).compare(0, 2, "--") == 0) {
+        std::string opt = argv[1];
+        int used = 1;
+        if (opt == "--json") {
+            json = true;
+        } else if (opt == "--png") {
+            png = true;
+        } else if (opt == "--png-level" && argc > 2) {
+            char* end;
+            long level = strtol(argv[2], &end, 10);
+            if (end == argv[2] || *end != '\0' || level < 0 || level > 9) {
+                std::cout << "ERROR: invalid --png-level value '" << argv[2] << "' (expected 0..9)." << std::endl;
+                return 2;
+            }
+            png = true;
+            png_options.level = (int)level;
+            used = 2;
+        } else if (opt == "--png-filter" && argc > 2) {
+            if (!f2i_stego_tools::parse_png_filter(argv[2], png_options.filter)) {
+                std::cout << "ERROR: invalid --png-filter value '" << argv[2]
+                          << "' (expected none|sub|up|avg|paeth|adaptive)." << std::endl;
+                return 2;
+            }
+            png = true;
+            used = 2;
+        } else {
+            std::cout << "ERROR: Unknown option \"" << opt << "\"." << std::endl;
+            return 2;
+        }
+        argv += used;
+        argc -= used;
+    }
+    std::string img_ext = png ? ".png" : ".bmp";
+
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    // single image, optionally compressed and keyed
+    if (mode == "encrypt" && argc >= 4) {
+        f2i_stego_tools::Result r = f2i_stego_tools::encrypt(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 1, 0,
+                                                             argc > 5 ? atoi(argv[5]) : 0, argc > 6 ? argv[6] : "",
+                                                             "encrypted" + img_ext, png_options);
+        if (json) std::cerr << f2i_stego_tools::to_json(r) << std::endl;
+        return r.status != f2i_stego_tools::SUCCESS ? 1 : 0;
+    }
+    if (mode == "decrypt" && argc >= 3) {
+        f2i_stego_tools::Result r = f2i_stego_tools::decrypt(argv[2], 0, argc > 3 ? argv[3] : "");
+        if (json) std::cerr << f2i_stego_tools::to_json(r) << std::endl;
+        return r.status != f2i_stego_tools::SUCCESS ? 1 : 0;
+    }
+
+    // random access: only the image bytes holding the range are read
+    if (mode == "extract" && argc >= 5) {
+        unsigned char key[f2i_stego_tools::KEY_BYTES];
+        if (argc > 5 && !f2i_stego_tools::load_key(argv[5], key)) {
+            std::cerr << "ERROR: Key file must hold exactly " << f2i_stego_tools::KEY_BYTES << " bytes." << std::endl;
+            return 2;
+        }
+        std::vector<unsigned char> out;
+        f2i_stego_tools::Result r = f2i_stego_tools::extract_range(argv[2], strtoull(argv[3], NULL, 10),
+            strtoull(argv[4], NULL, 10), out, argc > 5 ? key : NULL);
+        if (json) std::cerr << f2i_stego_tools::to_json(r) << std::endl;
+        if (r.status != f2i_stego_tools::SUCCESS) {
+            std::cerr << "ERROR: " << r.message << std::endl;
+            return 1;
+        }
+        if (!out.empty()) std::cout.write((const char*)&out[0], (std::streamsize)out.size());
+        return std::cout.flush() ? 0 : 1;
+    }
+
+    // integrity check: nothing is written; exit status 1 if any image fails
+    if (mode == "verify" && argc >= 3) {
+        int failed = 0;
+        for (int i=2; i<argc; i++) {
+            f2i_stego_tools::Result r = f2i_stego_tools::verify_file(argv[i]);
+            if (json) std::cerr << f2i_stego_tools::to_json(r) << std::endl;
+            if (r.status != f2i_stego_tools::SUCCESS) {
+                std::cout << argv[i] << ": ERROR: " << r.message << std::endl;
+                failed++;
+            } else {
+                std::cout << argv[i] << ": " << (r.checksummed ? "ok" : "ok (no checksum)") << std::endl;
+            }
+        }
+        return failed ? 1 : 0;
+    }
+
+    // scan: one line per carrier, tab separated
+    if (mode == "scan" && argc >= 3) {
+        std::vector<std::string> paths(argv + 2, argv + argc), files;
+        std::vector<f2i_stego_tools::Result> results;
+        int carriers = f2i_stego_tools::scan_images(paths, files, results);
+        for (int i=0; i<(int)files.size(); i++) {
+            const f2i_stego_tools::Result& r = results[i];
+            if (r.status != f2i_stego_tools::SUCCESS) continue;
+            std::cout << files[i] << "\t" << r.lsbs << "\t" << (r.extension.empty() ? "" : "." + r.extension)
+                      << "\t" << r.raw_bytes;
+            if (r.compressed) std::cout << "\tcompressed";
+            if (r.keyed) std::cout << "\tkeyed";
+            if (r.shard.count > 0) std::cout << "\tpiece " << r.shard.index+1 << "/" << r.shard.count;
+            std::cout << std::endl;
+        }
+        std::cerr << carriers << " of " << files.size() << " files carry data." << std::endl;
+        return 0;
+    }
+
+    // capacity check: only the image's file header is read
+    if (mode == "capacity" && argc >= 3) {
+        int lsbs = argc > 3 ? atoi(argv[3]) : 1;
+        long long bytes = f2i_stego_tools::capacity(argv[2], lsbs, "", png);
+        if (bytes < 0) {
+            std::cout << "ERROR: Image file could not be read, or lsbs is out of range for it." << std::endl;
+            return 2;
+        }
+        std::cout << bytes << std::endl;
+        return 0;
+    }
+
+    // fit check: the image's file header and the data file's size
+    if (mode == "fits" && argc >= 4) {
+        int lsbs = argc > 4 ? atoi(argv[4]) : 1;
+        long long bytes = f2i_stego_tools::capacity(argv[2], lsbs, "", png);
+        long long f_bytes = f2i_stego_tools::file_size(argv[3]);
+        if (bytes < 0 || f_bytes < 0) {
+            std::cout << "ERROR: Image or data file could not be read, or lsbs is out of range." << std::endl;
+            return 2;
+        }
+        bool ok = f2i_stego_tools::fits(argv[2], argv[3], lsbs, png);
+        std::cout << (ok ? "fits" : "does not fit") << std::endl;
+        return ok ? 0 : 1;
+    }
+
+    // batch: one "carrier payload lsbs output" job per manifest line
+    if (mode == "batch" && argc >= 3) {
+        std::vector<f2i_stego_tools::BatchJob> jobs;
+        std::string error;
+        if (!f2i_stego_tools::read_manifest(argv[2], jobs, error)) {
+            std::cout << "ERROR: " << error << std::endl;
+            return 2;
+        }
+        std::vector<f2i_stego_tools::Result> results;
+        f2i_stego_tools::BatchReport report =
+            f2i_stego_tools::run_batch(jobs, results, argc > 3 ? atoi(argv[3]) : 0, png_options);
+        for (int i=0; i<(int)results.size(); i++) {
+            if (json) std::cerr << f2i_stego_tools::to_json(results[i]) << std::endl;
+            if (results[i].status != f2i_stego_tools::SUCCESS)
+                std::cout << "ERROR: " << jobs[i].output << ": " << results[i].message << std::endl;
+        }
+        double seconds = report.seconds > 0 ? report.seconds : 1e-9;
+        std::cout << report.jobs - report.failed << "/" << report.jobs << " jobs in "
+                  << report.seconds << " s (" << report.jobs / seconds << " jobs/s, "
+                  << report.bytes / seconds / 1e6 << " MB/s)" << std::endl;
+        return report.failed ? 1 : 0;
+    }
+
+    // split: image i is saved as encrypted_<i>.bmp (or .png)
+    if (mode == "split" && argc >= 5) {
+        std::vector<std::string> images(argv + 4, argv + argc), outputs;
+        for (int i=0; i<(int)images.size(); i++)
+            outputs.push_back("encrypted_" + f2i_stego_tools::i2s(i) + img_ext);
+        std::vector<f2i_stego_tools::Result> results =
+            f2i_stego_tools::encrypt_shards(images, argv[2], outputs, atoi(argv[3]), 0, png_options);
+        int failed = 0;
+        for (int i=0; i<(int)results.size(); i++) {
+            if (json) std::cerr << f2i_stego_tools::to_json(results[i]) << std::endl;
+            if (results[i].status != f2i_stego_tools::SUCCESS) {
+                std::cout << "ERROR: " << images[i] << ": " << results[i].message << std::endl;
+                failed++;
+            } else {
+                std::cout << results[i].f_bytes << " bytes saved as \"" << outputs[i] << "\"." << std::endl;
+            }
+        }
+        return failed ? 1 : 0;
+    }
+
+    // join: the images may come in any order
+    if (mode == "join" && argc >= 3) {
+        std::vector<std::string> images(argv + 2, argv + argc);
+        f2i_stego_tools::Result r = f2i_stego_tools::decrypt_shards(images);
+        if (json) std::cerr << f2i_stego_tools::to_json(r) << std::endl;
+        if (r.status != f2i_stego_tools::SUCCESS) {
+            std::cout << "ERROR: " << r.message << std::endl;
+            return 1;
+        }
+        std::string ext = r.extension.empty() ? "" : "." + r.extension;
+        std::cout << r.f_bytes << " bytes from " << images.size()
+                  << " images saved as \"decrypted" << ext << "\"." << std::endl;
+        return 0;
+    }
+
+    // a mistyped mode, or a known one with too few arguments
+    if (!demo) {
+        std::cerr << USAGE;
+        return 2;
+    }
+
+    std::string img_filename = "tiger.bmp";
+    std::string file_filename = "LAA.exe";
+    int least_significant_bits = 7; // must be between 1 and 7, inclusive
+
+    // encrypt file data into image data
+    f2i_stego_tools::Result r = f2i_stego_tools::encrypt(img_filename, file_filename, least_significant_bits);
+    if (r.status != f2i_stego_tools::SUCCESS) return 1;
+
+    // decrypt image and save both the image and data file
+    r = f2i_stego_tools::decrypt("encrypted.bmp");
+    return r.status != f2i_stego_tools::SUCCESS ? 1 : 0;
+}
@@ -0,0 +1,443 @@
+#include "File2ImageStegoTools.h"
+#include "StegoKernels.h"
+#include "StegoCipher.h"
+#include "StegoChecksum.h"
+#include "StegoPng.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <zlib.h>
+
+// usage:
+//   stego_tests [check]
+//
+// runs the self-checks of the library (all of them, or the one named) and
+// exits with 1 if any fails:
+//   kernels      every supported embed/extract kernel set against the scalar one
+//   keystream    ChaCha20 against the published all-zero key vector, and every
+//                vector width against the scalar one
+//   crc32c       CRC32C against "123456789", the instruction against the tables and
+//                crc32c_combine() against one pass
+//   headers      version 2 headers at full field width, and version 1 images
+//   bands        embed/extract on several threads against one, at lsbs 1..7
+//   png          write_png()/read_png() with every filter at 8 and 16 bits, and an
+//                interlaced palette image with tRNS, as written here
+//   png_carrier  encrypt/decrypt at lsbs 8 through a 16-bit RGBA PNG
+//   deflate      encrypt/decrypt at levels 1 and 9, compressible and not, and the
+//                bits a streamed or deflated payload too large for its image needs
+//   ranges       extract_range() against a full decrypt at lsbs 1..7, keyed and not
+//   shards       split/join with the pieces shuffled, and nothing kept when a piece
+//                is missing, given twice or corrupted
+//   allocations  a second encrypt/decrypt of the same size with one Encoder and
+//                Decoder makes no heap allocations (operator new is counted)
+// checks that need files write them into the current directory and remove them
+
+namespace {
+
+    using namespace f2i_stego_tools;
+
+    // calls of operator new so far, on any thread
+    std::atomic<unsigned long long> news(0);
+
+    // a file name of its own for each check, so they can run side by side
+    std::string scratch(std::string name) {
+        return "stego_tests_" + name;
+    }
+
+    // appends a PNG chunk: length, type, data and CRC
+    void put_chunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data) {
+        unsigned long n = (unsigned long)data.size();
+        unsigned char len[4] = {(unsigned char)(n >> 24), (unsigned char)(n >> 16),
+                                (unsigned char)(n >> 8), (unsigned char)n};
+        png.insert(png.end(), len, len + 4);
+        unsigned long at = (unsigned long)png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        unsigned long crc = crc32(crc32(0, NULL, 0), &png[at], (uInt)(n + 4));
+        unsigned char sum[4] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16),
+                                (unsigned char)(crc >> 8), (unsigned char)crc};
+        png.insert(png.end(), sum, sum + 4);
+    }
+
+    // writes a palette image of w x h indices at this depth (1, 2, 4 or 8 bits),
+    // Adam7 interlaced or not, with a tRNS chunk; write_png() has no palettes
+    bool write_palette_png(std::string path, int w, int h, int depth, bool interlaced,
+                           const std::vector<unsigned char>& index, const std::vector<unsigned char>& palette,
+                           const std::vector<unsigned char>& trns) {
+        static const int X0[7] = {0, 4, 0, 2, 0, 1, 0}, Y0[7] = {0, 0, 4, 0, 2, 0, 1};
+        static const int DX[7] = {8, 8, 4, 4, 2, 2, 1}, DY[7] = {8, 8, 8, 4, 4, 2, 2};
+
+        // unfiltered rows (filter byte 0), pass after pass
+        std::vector<unsigned char> raw;
+        for (int p=0; p<(interlaced ? 7 : 1); p++) {
+            int x0 = interlaced ? X0[p] : 0, y0 = interlaced ? Y0[p] : 0;
+            int dx = interlaced ? DX[p] : 1, dy = interlaced ? DY[p] : 1;
+            int pw = (w - x0 + dx - 1) / dx, ph = (h - y0 + dy - 1) / dy;
+            if (pw <= 0 || ph <= 0) continue;
+            for (int y=y0; y<h; y+=dy) {
+                std::vector<unsigned char> row(1 + (pw*depth + 7) / 8, 0);
+                for (int i=0, x=x0; x<w; i++, x+=dx) {
+                    int bit = i*depth;
+                    row[1 + bit/8] |= (unsigned char)(index[y*w + x] << (8 - depth - bit%8));
+                }
+                raw.insert(raw.end(), row.begin(), row.end());
+            }
+        }
+        std::vector<unsigned char> idat(compressBound((uLong)raw.size()));
+        uLongf n = (uLongf)idat.size();
+        if (compress2(&idat[0], &n, &raw[0], (uLong)raw.size(), 9) != Z_OK) return false;
+        idat.resize(n);
+
+        static const unsigned char sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        std::vector<unsigned char> png(sig, sig + 8);
+        unsigned char ihdr[13] = {(unsigned char)(w >> 24), (unsigned char)(w >> 16), (unsigned char)(w >> 8),
+                                  (unsigned char)w, (unsigned char)(h >> 24), (unsigned char)(h >> 16),
+                                  (unsigned char)(h >> 8), (unsigned char)h, (unsigned char)depth, 3, 0, 0,
+                                  (unsigned char)(interlaced ? 1 : 0)};
+        put_chunk(png, "IHDR", std::vector<unsigned char>(ihdr, ihdr + 13));
+        put_chunk(png, "PLTE", palette);
+        put_chunk(png, "tRNS", trns);
+        put_chunk(png, "IDAT", idat);
+        put_chunk(png, "IEND", std::vector<unsigned char>());
+
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) return false;
+        bool written = fwrite(&png[0], 1, png.size(), f) == png.size();
+        return fclose(f) == 0 && written;
+    }
+
+    bool check_png(unsigned int seed) {
+        std::mt19937 rng(seed);
+        std::string path = scratch("png.png");
+        bool ok = true;
+
+        // every filter (and level) on RGB and RGBA, 8 and 16 bits: smooth
+        // rows with some noise, so the filters have something to predict
+        for (int depth=8; depth<=16 && ok; depth+=8) {
+            for (int channels=3; channels<=4 && ok; channels++) {
+                for (int f=PNG_NONE; f<=PNG_ADAPTIVE && ok; f++) {
+                    PngImage image, back;
+                    image.width = 1 + rng() % 40;
+                    image.height = 1 + rng() % 30;
+                    image.channels = channels;
+                    image.depth = depth;
+                    image.pixels.resize((size_t)image.width*image.height*channels*depth/8);
+                    for (unsigned long i=0; i<image.pixels.size(); i++)
+                        image.pixels[i] = (unsigned char)(i*3 + i/(image.width*channels) + rng() % 4);
+                    PngOptions options;
+                    options.filter = (PngFilter)f;
+                    options.level = rng() % 10;
+                    ok = write_png(path, image, options) && read_png(path, back) &&
+                         back.width == image.width && back.height == image.height &&
+                         back.channels == channels && back.depth == depth && back.pixels == image.pixels;
+                }
+            }
+        }
+
+        // palette images at every depth, plain and interlaced, come back as
+        // 8-bit R,G,B,A with the tRNS entries as alpha (opaque past them)
+        for (int depth=1; depth<=8 && ok; depth*=2) {
+            for (int interlaced=0; interlaced<=1 && ok; interlaced++) {
+                int w = 1 + rng() % 21, h = 1 + rng() % 21, colors = 1 << depth;
+                std::vector<unsigned char> index(w*h), palette(3*colors), trns(1 + rng() % colors);
+                for (int i=0; i<w*h; i++) index[i] = (unsigned char)(rng() % colors);
+                for (int i=0; i<3*colors; i++) palette[i] = (unsigned char)rng();
+                for (int i=0; i<(int)trns.size(); i++) trns[i] = (unsigned char)rng();
+                trns[0] = 0;
+
+                PngImage back;
+                int fw, fh, channels, sample_bits;
+                ok = write_palette_png(path, w, h, depth, interlaced != 0, index, palette, trns) &&
+                     read_png(path, back) && back.width == w && back.height == h &&
+                     back.channels == 4 && back.depth == 8 &&
+                     image_format(path, fw, fh, channels, sample_bits) && channels == 4 && sample_bits == 8;
+                for (int i=0; i<w*h && ok; i++) {
+                    int k = index[i];
+                    unsigned char want[4] = {palette[3*k], palette[3*k+1], palette[3*k+2],
+                                             (unsigned char)(k < (int)trns.size() ? trns[k] : 255)};
+                    ok = std::equal(want, want + 4, &back.pixels[4*i]);
+                }
+            }
+        }
+        std::remove(path.c_str());
+        return ok;
+    }
+
+    bool check_png_carrier(unsigned int seed) {
+        std::mt19937 rng(seed);
+        std::string path = scratch("png_carrier.png");
+
+        // a 16-bit RGBA carrier with noise in every sample
+        PngImage image;
+        image.width = 50 + rng() % 50;
+        image.height = 20 + rng() % 20;
+        image.channels = 4;
+        image.depth = 16;
+        image.pixels.resize((size_t)image.width*image.height*8);
+        for (unsigned long i=0; i<image.pixels.size(); i++) image.pixels[i] = (unsigned char)rng();
+        std::vector<unsigned char> before = image.pixels;
+        if (!write_png(path, image)) return false;
+
+        // at lsbs 8 a PNG output holds a byte per sample, less the header
+        long long room = capacity(path, 8, "bin", true);
+        std::remove(path.c_str());
+        if (room <= 0 || room >= (long long)image.width*image.height*4) return false;
+        std::vector<unsigned char> data((size_t)room + 1);
+        for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)rng();
+
+        // the low byte of each big-endian sample is the second one
+        RGBView view(&image.pixels[1], image.width, image.height, 2, 8, 8L*image.width, 4, 16);
+        Encoder encoder(8, 2);
+        if (encoder.encrypt(view, &data[0], data.size(), "bin").status != TOO_LARGE) return false;
+        data.pop_back();
+        Result r = encoder.encrypt(view, &data[0], data.size(), "bin");
+        if (r.status != SUCCESS || r.lsbs != 8 || r.channels != 4 || r.sample_bits != 16) return false;
+
+        // only low bytes changed, and the data survives a write and a read
+        for (unsigned long i=0; i<before.size(); i+=2)
+            if (image.pixels[i] != before[i]) return false;
+        PngImage back;
+        bool ok = write_png(path, image) && read_png(path, back) && back.pixels == image.pixels;
+        std::remove(path.c_str());
+        if (!ok) return false;
+        RGBView back_view(&back.pixels[1], back.width, back.height, 2, 8, 8L*back.width, 4, 16);
+        std::vector<unsigned char> out;
+        r = decrypt(back_view, out, 2);
+        return r.status == SUCCESS && r.lsbs == 8 && r.extension == "bin" && out == data;
+    }
+
+    bool check_deflate(unsigned int seed) {
+        std::mt19937 rng(seed);
+        int w = 200 + rng() % 100, h = 100 + rng() % 100;
+        std::vector<unsigned char> rgb(3*w*h), out;
+        for (unsigned long i=0; i<rgb.size(); i++) rgb[i] = (unsigned char)rng();
+        RGBView view(&rgb[0], w, h, 1, 3, 3L*w);
+
+        for (int level=1; level<=9; level+=8) {
+            for (int compressible=0; compressible<=1; compressible++) {
+                std::vector<unsigned char> data(1 + rng() % (w*h/2));
+                for (unsigned long i=0; i<data.size(); i++)
+                    data[i] = (unsigned char)(compressible ? i / 64 % 7 : rng());
+                int lsbs = 2 + rng() % 6;
+                Result e = Encoder(lsbs, 2, level).encrypt(view, &data[0], data.size(), "bin");
+                Result d = decrypt(view, out, 2);
+                if (e.status != SUCCESS || !e.compressed || e.raw_bytes != data.size() ||
+                    (compressible && e.f_bytes >= data.size()) || d.status != SUCCESS ||
+                    !d.compressed || out != data)
+                    return false;
+            }
+        }
+
+        // too large: the whole payload is counted, whether its size is only
+        // found by reading it (streamed) or by deflating it, also past the
+        // first block read
+        std::vector<unsigned char> data((9 << 20) + rng() % 1000);
+        for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)rng();
+        for (int level=0; level<=1; level++) {
+            unsigned long at = 0;
+            Encoder encoder(1, 2, level);
+            Result r = encoder.encrypt_stream(view, [&](unsigned char* buf, unsigned long n) -> long {
+                if (n > data.size() - at) n = (unsigned long)(data.size() - at);
+                memcpy(buf, &data[at], n);
+                at += n;
+                return (long)n;
+            }, -1, "bin");
+            if (r.status != TOO_LARGE || r.raw_bytes != data.size() || r.f_bytes < data.size() ||
+                (level == 0 && r.f_bytes != data.size()) || r.bits <= r.f_bytes*8)
+                return false;
+        }
+        return true;
+    }
+
+    bool check_ranges(unsigned int seed) {
+        std::mt19937 rng(seed);
+        int w = 100 + rng() % 50, h = 50 + rng() % 50;
+        std::vector<unsigned char> rgb(3*w*h), full, part;
+        for (unsigned long i=0; i<rgb.size(); i++) rgb[i] = (unsigned char)rng();
+        unsigned char key[KEY_BYTES];
+        for (int i=0; i<KEY_BYTES; i++) key[i] = (unsigned char)rng();
+        RGBView view(&rgb[0], w, h, 1, 3, 3L*w);
+
+        for (int lsbs=1; lsbs<=7; lsbs++) {
+            for (int keyed=0; keyed<=1; keyed++) {
+                std::vector<unsigned char> data(100 + rng() % 900);
+                for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)rng();
+                Encoder encoder(lsbs, 2);
+                Decoder decoder(2);
+                encoder.set_key(keyed ? key : NULL);
+                decoder.set_key(keyed ? key : NULL);
+                if (encoder.encrypt(view, &data[0], data.size(), "bin").status != SUCCESS ||
+                    decoder.decrypt(view, full).status != SUCCESS || full != data)
+                    return false;
+
+                // the start, an odd offset (so the range starts inside a
+                // sample at odd lsbs), the last byte, nothing at the end
+                unsigned long long n = data.size(), odd = 1 + 2*(rng() % (n/2 - 1));
+                unsigned long long ranges[4][2] = {{0, 1 + rng() % n}, {odd, 1 + rng() % (n - odd)},
+                                                   {n - 1, 1}, {n, 0}};
+                for (int k=0; k<4; k++) {
+                    unsigned long long offset = ranges[k][0], length = ranges[k][1];
+                    Result r = decoder.extract_range(view, offset, length, part);
+                    if (r.status != SUCCESS || part.size() != length ||
+                        !std::equal(part.begin(), part.end(), full.begin() + offset))
+                        return false;
+                }
+                if (decoder.extract_range(view, n - 1, 2, part).status != BAD_ARGUMENT) return false;
+            }
+        }
+        return true;
+    }
+
+    // whether a file exists
+    bool exists(std::string path) {
+        return std::ifstream(path.c_str()).good();
+    }
+
+    bool check_shards(unsigned int seed) {
+        std::mt19937 rng(seed);
+        const int N = 3;
+        std::vector<std::string> carriers, pieces;
+        for (int i=0; i<N; i++) {
+            PngImage image;
+            image.width = 60 + rng() % 40;
+            image.height = 40 + rng() % 40;
+            image.pixels.resize((size_t)image.width*image.height*3);
+            for (unsigned long k=0; k<image.pixels.size(); k++) image.pixels[k] = (unsigned char)rng();
+            carriers.push_back(scratch("shards_carrier_" + i2s(i) + ".png"));
+            pieces.push_back(scratch("shards_piece_" + i2s(i) + ".png"));
+            if (!write_png(carriers[i], image)) return false;
+        }
+        std::string payload = scratch("shards_payload.dat"), joined = scratch("shards_joined");
+        std::vector<unsigned char> data(4000 + rng() % 4000);
+        for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)rng();
+        std::ofstream(payload.c_str(), std::ios::binary).write((const char*)&data[0], (std::streamsize)data.size());
+
+        bool ok = true;
+        std::vector<Result> split = encrypt_shards(carriers, payload, pieces, 2, 2);
+        for (int i=0; i<N; i++) ok = ok && split[i].status == SUCCESS && split[i].shard.count == N;
+
+        // any order puts the data file back together
+        std::vector<std::string> shuffled(pieces);
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+        ok = ok && decrypt_shards(shuffled, joined, 2).status == SUCCESS;
+        std::ifstream in((joined + ".dat").c_str(), std::ios::binary);
+        std::vector<unsigned char> back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        ok = ok && back == data;
+        std::remove((joined + ".dat").c_str());
+
+        // a piece missing or given twice
+        std::vector<std::string> missing(shuffled.begin(), shuffled.end() - 1), twice(missing);
+        twice.push_back(missing[0]);
+        ok = ok && decrypt_shards(missing, joined, 2).status == CORRUPTED && !exists(joined + ".dat");
+        ok = ok && decrypt_shards(twice, joined, 2).status == CORRUPTED && !exists(joined + ".dat");
+
+        // a piece whose data (right after its header) no longer matches its
+        // checksum, found only once the other pieces have been written
+        PngImage image;
+        ok = ok && read_png(pieces[1], image);
+        for (unsigned long k=400; ok && k<464; k++) image.pixels[k] ^= 1;
+        ok = ok && write_png(pieces[1], image) && decrypt_shards(shuffled, joined, 2).status == CORRUPTED &&
+             !exists(joined + ".dat");
+
+        for (int i=0; i<N; i++) {
+            std::remove(carriers[i].c_str());
+            std::remove(pieces[i].c_str());
+        }
+        std::remove(payload.c_str());
+        return ok;
+    }
+
+    bool check_allocations(unsigned int seed) {
+        std::mt19937 rng(seed);
+
+        // a carrier of a few bands, so the worker threads take part too, and
+        // data that deflates a little
+        int w = 1024, h = 1100;
+        std::vector<unsigned char> rgb(3*w*h), data(1100000), out;
+        for (unsigned long i=0; i<rgb.size(); i++) rgb[i] = (unsigned char)rng();
+        for (unsigned long i=0; i<data.size(); i++) data[i] = (unsigned char)(rng() % 16);
+        unsigned char key[KEY_BYTES];
+        for (int i=0; i<KEY_BYTES; i++) key[i] = (unsigned char)rng();
+        RGBView view(&rgb[0], w, h, 1, 3, 3L*w);
+
+        for (int level=0; level<=6; level+=6) {
+            for (int keyed=0; keyed<=1; keyed++) {
+                Encoder encoder(3, 4, level);
+                Decoder decoder(4);
+                encoder.set_key(keyed ? key : NULL);
+                decoder.set_key(keyed ? key : NULL);
+                for (int pass=0; pass<2; pass++) {
+                    unsigned long long before = news;
+                    Result e = encoder.encrypt(view, &data[0], data.size(), "bin");
+                    Result d = decoder.decrypt(view, out);
+                    if (pass == 1 && news != before) return false;
+                    if (e.status != SUCCESS || d.status != SUCCESS || out != data) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // a self-check and the name it is run by
+    struct Check {
+        const char* name;
+        bool (*run)(unsigned int seed);
+    };
+
+    const Check CHECKS[] = {
+        {"kernels", check_kernels},
+        {"keystream", check_keystream},
+        {"crc32c", check_crc32c},
+        {"headers", check_headers},
+        {"bands", check_bands},
+        {"png", check_png},
+        {"png_carrier", check_png_carrier},
+        {"deflate", check_deflate},
+        {"ranges", check_ranges},
+        {"shards", check_shards},
+        {"allocations", check_allocations},
+    };
+}
+
+// every heap allocation of the process goes through these, so the
+// allocations check sees what the library really allocates
+void* operator new(std::size_t n) {
+    news++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char** argv) {
+    std::string only = argc > 1 ? argv[1] : "";
+    bool found = false, failed = false;
+    for (unsigned long i=0; i<sizeof(CHECKS)/sizeof(CHECKS[0]); i++) {
+        if (!only.empty() && only != CHECKS[i].name) continue;
+        found = true;
+
+        // a few seeds, so each run covers more than one set of random cases
+        bool ok = true;
+        for (unsigned int seed=1; seed<=4 && ok; seed++) ok = CHECKS[i].run(seed);
+        std::cout << CHECKS[i].name << ": " << (ok ? "ok" : "FAILED") << std::endl;
+        failed = failed || !ok;
+    }
+    if (!found) {
+        std::cout << "ERROR: Unknown check \"" << only << "\"." << std::endl;
+        return 2;
+    }
+    return failed ? 1 : 0;
+}